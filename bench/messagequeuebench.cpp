@@ -0,0 +1,281 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file messagequeuebench.cpp
+    @brief Benchmark of the ways of passing messages to the GUI thread
+
+    Compares the two ways the commsthread has used to hand messages to
+    an Application in the GUI thread:
+
+    - postevent: one heap-allocated event per message, carrying a copy
+      of the command array, through Qt's event queue (the old
+      CommsThreadEvent).
+    - lfqueue: a bounded single-producer/single-consumer queue per
+      Application and a single wakeup event per burst (what
+      Application::postMessage does now).
+
+    A producer thread sends bursts of messages and the GUI thread
+    optionally does some work for each one. For each method the
+    throughput, the number of events the GUI thread had to handle and
+    the latency from sending to handling are reported.
+
+    Usage: messagequeuebench [messages [burst [gap_ms [work_us]]]]
+
+    @author Robert Haines */
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QObject>
+#include <QThread>
+
+#include <algorithm>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/lfQueue.h>
+
+#include "types.h"
+
+static lunchbox::Clock sClock;
+
+static int64_t
+nowMicros()
+{
+  return (int64_t)(sClock.getTimed() * 1000.0);
+}
+
+/// @return the latency that aPercent of the sorted aLatencies are at
+/// or below
+static int64_t
+getPercentile(const std::vector<int64_t> &aLatencies, const double aPercent)
+{
+  if(aLatencies.empty())
+    return 0;
+
+  const size_t lIndex = (size_t)(aPercent / 100.0 * (aLatencies.size() - 1));
+  return aLatencies[lIndex];
+}
+
+enum Method { kPOST_EVENT, kLF_QUEUE };
+
+/// One message as the old CommsThreadEvent carried it
+class PerMessageEvent : public QEvent {
+public:
+  PerMessageEvent(const int aMsgType, const int64_t aSent)
+    : QEvent((QEvent::Type)(QEvent::User + kMSG_EVENT)),
+      mMsgType(aMsgType), mSent(aSent) {
+    for(int i = 0; i < REG_MAX_NUM_STR_CMDS; i++)
+      mCommands[i] = i;
+  }
+
+  int     mMsgType;
+  int64_t mSent;
+  int     mCommands[REG_MAX_NUM_STR_CMDS];
+};
+
+/// One message as it sits in an Application's queue
+struct QueuedMessage {
+  int     mMsgType;
+  int64_t mSent;
+};
+
+/// Stands in for an Application: lives in the GUI thread and handles
+/// the messages sent to it by the Producer
+class Receiver : public QObject {
+public:
+  Receiver(const Method aMethod, const int aExpected, const int aWorkMicros)
+    : mMethod(aMethod), mExpected(aExpected), mWorkMicros(aWorkMicros),
+      mReceived(0), mEvents(0), mFinished(0),
+      mMessages(kMSG_QUEUE_SIZE), mWakeupPending(0) {
+    mLatencies.reserve(aExpected);
+  }
+
+  /// Called by the Producer thread
+  /// @return false if the queue is full
+  bool post(const int aMsgType) {
+    if(mMethod == kPOST_EVENT) {
+      QCoreApplication::postEvent(this,
+				  new PerMessageEvent(aMsgType, nowMicros()));
+      return true;
+    }
+
+    QueuedMessage lMessage;
+    lMessage.mMsgType = aMsgType;
+    lMessage.mSent = nowMicros();
+    if(!mMessages.push(lMessage))
+      return false;
+
+    if(mWakeupPending.testAndSetOrdered(0, 1))
+      QCoreApplication::postEvent(this, new QEvent((QEvent::Type)
+						   (QEvent::User + kMSG_EVENT)));
+    return true;
+  }
+
+  void customEvent(QEvent *aEvent) {
+    mEvents++;
+
+    if(mMethod == kPOST_EVENT) {
+      handle(((PerMessageEvent *) aEvent)->mSent);
+    }
+    else {
+      mWakeupPending.fetchAndStoreOrdered(0);
+
+      QueuedMessage lMessage;
+      while(mMessages.pop(lMessage))
+	handle(lMessage.mSent);
+    }
+
+    if(mReceived == mExpected) {
+      mFinished = nowMicros();
+      QCoreApplication::quit();
+    }
+  }
+
+  std::vector<int64_t> &getLatencies() { return mLatencies; }
+  int getNumEvents() const { return mEvents; }
+  int64_t getFinished() const { return mFinished; }
+
+private:
+  void handle(const int64_t aSent) {
+    const int64_t lStart = nowMicros();
+    mLatencies.push_back(lStart - aSent);
+    mReceived++;
+
+    // stand in for redrawing tables and so on
+    while(nowMicros() - lStart < mWorkMicros)
+      ;
+  }
+
+  const Method     mMethod;
+  const int        mExpected;
+  const int        mWorkMicros;
+  int              mReceived;
+  int              mEvents;
+  int64_t          mFinished;
+  std::vector<int64_t> mLatencies;
+
+  lunchbox::LFQueue<QueuedMessage> mMessages;
+  QAtomicInt       mWakeupPending;
+};
+
+/// Stands in for the CommsThread
+class Producer : public QThread {
+public:
+  Producer(Receiver &aReceiver, const int aMessages, const int aBurst,
+	   const int aGapMsecs)
+    : mReceiver(aReceiver), mMessages(aMessages), mBurst(aBurst),
+      mGapMsecs(aGapMsecs) {}
+
+  void run() {
+    for(int i = 0; i < mMessages; i++) {
+      // as the CommsThread did before it could pause an application,
+      // wait for the GUI if the queue is full
+      while(!mReceiver.post(i))
+	usleep(100);
+
+      if(mGapMsecs > 0 && (i + 1) % mBurst == 0)
+	msleep(mGapMsecs);
+    }
+  }
+
+private:
+  Receiver &mReceiver;
+  const int mMessages;
+  const int mBurst;
+  const int mGapMsecs;
+};
+
+int
+main(int argc, char **argv)
+{
+  QCoreApplication lApp(argc, argv);
+
+  const int lMessages = argc > 1 ? atoi(argv[1]) : 200000;
+  const int lBurst = argc > 2 ? atoi(argv[2]) : 64;
+  const int lGapMsecs = argc > 3 ? atoi(argv[3]) : 0;
+  const int lWorkMicros = argc > 4 ? atoi(argv[4]) : 0;
+
+  if(lMessages < 1 || lBurst < 1 || lGapMsecs < 0 || lWorkMicros < 0) {
+    fprintf(stderr,
+	    "Usage: %s [messages [burst [gap_ms [work_us]]]]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%d messages in bursts of %d, %d ms apart, %d us work each\n",
+	 lMessages, lBurst, lGapMsecs, lWorkMicros);
+  printf("%-10s %10s %12s %10s %10s %10s %10s\n", "method", "msecs",
+	 "msgs/sec", "events", "p50 us", "p99 us", "max us");
+
+  const Method lMethods[] = { kPOST_EVENT, kLF_QUEUE };
+  const char *lNames[] = { "postevent", "lfqueue" };
+
+  for(int i = 0; i < 2; i++) {
+    Receiver lReceiver(lMethods[i], lMessages, lWorkMicros);
+    Producer lProducer(lReceiver, lMessages, lBurst, lGapMsecs);
+
+    const int64_t lStart = nowMicros();
+    lProducer.start();
+    lApp.exec();
+    lProducer.wait();
+
+    const double lMsecs = (lReceiver.getFinished() - lStart) / 1000.0;
+    std::vector<int64_t> &lLatencies = lReceiver.getLatencies();
+    std::sort(lLatencies.begin(), lLatencies.end());
+    printf("%-10s %10.1f %12.0f %10d %10ld %10ld %10ld\n", lNames[i],
+	   lMsecs, lMsecs > 0.0 ? lMessages * 1000.0 / lMsecs : 0.0,
+	   lReceiver.getNumEvents(),
+	   (long) getPercentile(lLatencies, 50.0),
+	   (long) getPercentile(lLatencies, 99.0),
+	   (long) getPercentile(lLatencies, 100.0));
+  }
+
+  return 0;
+}
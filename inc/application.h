@@ -58,8 +58,14 @@
 #include <qwidget.h>
 #include <qmutex.h>
 #include <QEvent>
+#include <QAtomicInt>
+#include <lunchbox/clock.h>
+#include <lunchbox/lfQueue.h>
+#include <boost/shared_ptr.hpp>
 
 #include "types.h"
+#include "latencystats.h"
+#include "historytable.h"
 
 class Q3GroupBox;
 class QPushButton;
@@ -67,7 +73,10 @@ class QString;
 
 class ControlForm;
 class SteererMainWindow;
-class CommsThreadEvent;
+class ReGExecutor;
+class HistorySpool;
+class HistoryCache;
+class HistoryCacheLoader;
 
 /** Holds information on an application that the steering client is
     attached to */
@@ -77,13 +86,28 @@ class Application : public QWidget
 
 public:
 
+  /// @param aHistoryKey Where the application is, which its cached
+  /// parameter histories are kept by
   Application(QWidget *mParent, const char *, int aSimHandle,
 	      bool aIsLocal,
-	      QMutex *aMutex);
+	      ReGExecutor *aExecutor,
+	      const QString &aHistoryKey);
   ~Application();
 
   void customEvent(QEvent *);
-  void processNextMessage(CommsThreadEvent *aEvent);
+  /// Queue a message for processing by the GUI thread. Only the
+  /// CommsThread calls this.
+  /// @param aMsgType The type of the message
+  /// @param aStamps When it passed through the CommsThread
+  /// @return false if the queue is full
+  bool postMessage(const int aMsgType, const LatencyStats::Stamps &aStamps);
+  void processNextMessage(const int aMsgType);
+  /// Start timing how long this application takes to show its
+  /// parameters, for the debug log
+  /// @param aAttachMs How long the attach call took
+  /// @param aReadyMs How long from the attach call until the form
+  /// was ready
+  void startTiming(const float aAttachMs, const float aReadyMs);
   /// Enable all the command buttons for this application
   void enableCmdButtons();
 
@@ -92,6 +116,16 @@ public:
   bool isLocal(){return mIsLocal;}
   /// Getter method for handle of application
   int  getHandle();
+  /// Getter method for the file this application's parameter
+  /// histories are spooled to; NULL if they are kept in memory
+  boost::shared_ptr<HistorySpool> getHistorySpool();
+  /// Getter method for the table of values logged from this
+  /// application's status messages
+  HistoryTable *getHistoryTable();
+  /// Getter method for the cache of this application's parameter
+  /// histories from earlier attaches; NULL if there isn't one or it
+  /// hasn't finished loading
+  HistoryCache *getHistoryCache();
   /// Set the string holding the current application status
   void setCurrentStatus(QString &msg);
   /// Get the string holding the current application status
@@ -122,6 +156,11 @@ private:
   void detachFromApplication();
   void disableForDetach(const bool aUnRegister = true);
   void disableForDetachOnError();
+  /// Save the parameter histories to the cache, if there is one, once
+  /// we have finished with the application
+  void saveHistoryCache();
+  /// Wait for the cache to load, if it is loading, and use it
+  void finishLoadingHistoryCache();
   /** Sends the single, supplied command to the application
       @returns REG_SUCCESS or REG_FAILURE */
   int  emitSingleCmd(int aCmdId);
@@ -141,8 +180,8 @@ signals:
 private:
   const int	mSimHandle;
 
-  /** Pointer to mutex controlling access to steering lib */
-  QMutex        *mMutexPtr;
+  /** Pointer to the thread that makes all steering library calls */
+  ReGExecutor   *mExecutor;
   int		mNumCommands;
   bool		mDetachSupported;
   bool		mStopSupported;
@@ -155,6 +194,52 @@ private:
   ControlForm	*mControlForm;
   Q3GroupBox	*mControlBox;
   SteererMainWindow *mSteerer;
+  /// Where old parameter history values are moved out to, shared
+  /// with the parameters so it lasts as long as they do
+  boost::shared_ptr<HistorySpool> mHistorySpool;
+  /// The values logged from status messages
+  HistoryTable  mHistoryTable;
+  /// The parameter histories from earlier attaches, and where to save
+  /// these ones
+  boost::shared_ptr<HistoryCache> mHistoryCache;
+  /// Loads mHistoryCache, until it has finished
+  HistoryCacheLoader *mHistoryCacheLoader;
+  /// Whether the log has been fetched, after which anything left in
+  /// mHistoryCache isn't needed
+  bool          mHistoryLogFetched;
+  /// Whether the parameter histories have been saved to mHistoryCache
+  bool          mHistorySaved;
+
+  /// A message passed on by the CommsThread
+  struct QueuedMessage {
+    int                  mMsgType;
+    LatencyStats::Stamps mStamps;
+  };
+  /// Messages passed on by the CommsThread that are waiting to be
+  /// processed. The CommsThread is the only writer and the GUI thread
+  /// the only reader so no locking is needed.
+  lunchbox::LFQueue<QueuedMessage> mMessages;
+  /// Set while there is an event in the Qt queue telling us to empty
+  /// mMessages, so that a burst of messages only posts one event
+  QAtomicInt    mWakeupPending;
+
+  /// Times from the attach call to the first message and the first
+  /// paint of the parameter table (milliseconds)
+  lunchbox::Clock mStartupClock;
+  float         mAttachMs;
+  float         mReadyMs;
+  float         mFirstMessageMs;
+  float         mFirstPaintMs;
+  bool          mAwaitingFirstPaint;
+
+  /// Whether the last update from the CommsThread was history-only,
+  /// i.e. we have fallen behind the application
+  bool          mHistoryOnly;
+
+protected:
+  /// Spots the first paint of the parameter table after it has been
+  /// filled in
+  bool eventFilter(QObject *aObject, QEvent *aEvent);
 
   bool mChkTableVisible;
   bool mIOTableVisible;
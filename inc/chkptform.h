@@ -53,13 +53,13 @@
 
 #include <qdialog.h>
 #include <q3listbox.h>
-#include <qmutex.h>
 
 #include "ReG_Steer_Steerside.h"
 
 class QLineEdit;
 class QPushButton;
 class Q3ListBoxItem;
+class ReGExecutor;
 
 class ChkPtForm: public QDialog
 {
@@ -67,7 +67,7 @@ class ChkPtForm: public QDialog
 
 public:
   ChkPtForm(const int aNumEntries, int aSimHandle, int aChkPtHandle,
-	    QMutex *aMutex, QWidget *parent = 0, const char *name = "chkptform",
+	    ReGExecutor *aExecutor, QWidget *parent = 0, const char *name = "chkptform",
 	    bool modal = TRUE, Qt::WFlags f = 0);
   ~ChkPtForm();
 
@@ -98,8 +98,8 @@ private:
 
   QPushButton		*mRestartButton;
   QPushButton		*mCancelButton;
-  /** Pointer to mutex protecting ReG library calls */
-  QMutex                *mMutexPtr;
+  /** Pointer to the thread that makes all ReG library calls */
+  ReGExecutor           *mExecutor;
 };
 
 
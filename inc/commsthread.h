@@ -56,65 +56,176 @@
 //Added by qt3to4:
 #include <QCustomEvent>
 #include <QMutex>
+#include <map>
+
+#include "commswaiter.h"
+#include "dirwatcher.h"
+#include "latencystats.h"
+#include "pollscheduler.h"
+#include "regexecutor.h"
+#include "statusupdate.h"
 
 class SteererMainWindow;
+class Application;
 
 class CommsThread : public QThread
 {
 public:
-    CommsThread(SteererMainWindow *, QMutex *, int aCheckInterval=kMIN_POLLING_INT);
+    CommsThread(SteererMainWindow *, ReGExecutor *, int aCheckInterval=kMIN_POLLING_INT);
     ~CommsThread();
 
     void setCheckInterval(const int aInterval);
     int getCheckInterval() const;
     void setUseAutoPollFlag(const int aFlag);
     bool getUseAutoPollFlag() const;
+    /// Set the latency to aim for with auto polling (milliseconds)
+    void setLatencyTarget(const int aLatencyTarget);
+    int getLatencyTarget() const;
+    /// How an application is being polled, for display
+    /// @return false if it isn't
+    bool getPollStats(const int aSimHandle,
+		      PollScheduler::AppStats &aStats) const;
     void stop();
     void handleSignal();
+    /// Interrupt the current sleep so that the thread polls for
+    /// messages straight away
+    void wakeup();
+    /// Tell the thread about a newly attached application once its
+    /// form is ready. The thread doesn't start polling until the
+    /// first application has been added.
+    /// @param aSimHandle The handle of the application
+    /// @param aApp The application its messages are passed on to,
+    /// until it is removed
+    /// @param aFd If not -1, a descriptor that becomes readable when
+    /// the application has sent us something. The thread wakes up as
+    /// soon as that happens rather than at the end of the polling
+    /// interval.
+    /// @param aSteerDir For the Files transport, the directory the
+    /// application writes its messages to. If it can be watched the
+    /// thread wakes up when a new file appears in it.
+    void addApplication(const int aSimHandle, Application *aApp,
+			const int aFd = -1,
+			const QString &aSteerDir = QString::null);
+    /// Tell the thread that an application has gone away
+    void removeApplication(const int aSimHandle);
+    /// Collect the updates read for an application since this was
+    /// last called. If there are many the application is put into
+    /// history-only mode until the GUI has caught up. If polling it
+    /// had been paused because the GUI had fallen too far behind, it
+    /// starts again.
+    /// @return false if there are none
+    bool takeStatusUpdate(const int aSimHandle, StatusUpdate &aUpdate);
 
 protected:
     virtual void run();
 
 private:
     void setKeepRunning(const bool aFlag);
+    /// Get the next message (if any) from the library and pass it on
+    /// to its Application.
+    /// @param aRecordPoll Whether to tell the scheduler about this poll
+    /// as well as about the message
+    /// @param aSimHandle Set to the handle of the application the
+    /// message came from
+    /// @return The type of the message, MSG_NOTSET if there was none
+    int handleNextMessage(const bool aRecordPoll, int &aSimHandle);
+    /// What happened to a message passed on to an Application
+    enum PostResult { kPOSTED, kQUEUE_FULL, kNO_APPLICATION };
+    /// Pass a message on to the Application for a sim, if it hasn't
+    /// been removed
+    PostResult postToApplication(const int aSimHandle, const int aMsgType,
+				 const LatencyStats::Stamps &aStamps);
+    /// Read the state that a message has changed from the library
+    /// and add it to the updates waiting for the GUI.
+    /// @return true if there were none waiting, in which case the GUI
+    /// needs to be told
+    bool queueUpdate(const int aSimHandle, const int aMsgType,
+		     const int aSeqNum, const int aNumCmds,
+		     const int *aCommands);
+    /// Read the state of an application's (steered or monitored)
+    /// parameters from the library
+    bool getParamStates(const int aSimHandle, const bool aSteeredFlag,
+			std::vector<ParamState> &aParams);
+    /// Read the state of an application's IOTypes or ChkTypes from the
+    /// library
+    bool getIOTypeStates(const int aSimHandle, const bool aChkPtType,
+			 std::vector<IOTypeState> &aTypes);
+    /// Number of status messages waiting for the GUI for a sim
+    unsigned int pendingRecords(const int aSimHandle) const;
+    /// Add the values of all but string parameters to aRecord
+    void addToRecord(const std::vector<ParamState> &aParams,
+		     StatusRecord &aRecord);
+    /// Stop polling an application whose GUI has fallen too far
+    /// behind, or start again once it has caught up. Its descriptor
+    /// or directory isn't watched while it is paused.
+    void setPaused(const int aSimHandle, const bool aPaused);
+    /// Whether polling an application is paused
+    bool isPaused(const int aSimHandle) const;
+    /// Whether any applications have been added
+    bool hasApplications() const;
+    /// Whether every attached application has a watched descriptor
+    /// or directory, in which case there is no need to poll on a timer
+    bool allApplicationsWatched() const;
+    /// Consume pending directory events.
+    /// @return true if there were any
+    bool drainDirWatcher();
 
 private:
     SteererMainWindow	*mSteerer;
-    bool		mKeepRunningFlag;
-    int			mCheckInterval;  //milliseconds
+    /// Cleared by stop() from another thread
+    volatile bool	mKeepRunningFlag;
+    /// Polling interval for new applications and when auto polling
+    /// is off (milliseconds)
+    int			mCheckInterval;
     bool                mUseAutoPollInterval;
-    int                 mPollCount;
-    int                 mMsgCount;
-    // How many polls to average over in order to decide whether
-    // or not to adjust the polling interval
-    int                 mPollAdjustInterval;
-    int                 mMinPollAdjustInterval;
-    QMutex             *mMutexPtr;
-};
-
-
-class CommsThreadEvent : public QCustomEvent
-{
-
-public:
-  CommsThreadEvent(int aMsgType);
-  ~CommsThreadEvent();
-
-  int  getMsgType() const;
-  void storeCommands(int aNum, int *aArray);
-  int  getNumCmds() const;
-  int *getCmdsPtr();
-
-private:
-  /** The type of the message that generated this event */
-  int mMsgType;
-  /** The number of commands in the control message that generated
-      this event */
-  int mNumCmds;
-  /** Array holding the commands in the control message that generated
-      this event */
-  int mCommands[REG_MAX_NUM_STR_CMDS];
-
+    /// Makes all of our steering library calls
+    ReGExecutor        *mExecutor;
+    /// Where the time taken to handle each message is recorded
+    LatencyStats       *mLatencyStats;
+    /// When each application is next due to be polled
+    PollScheduler       mScheduler;
+    /// Most messages to handle before sleeping again
+    int                 mDrainMaxMessages;
+    /// Most time to spend handling messages before sleeping again
+    int                 mDrainMaxMsecs;
+    lunchbox::Clock     mClock;
+    /// Updates not yet picked up by the GUI, keyed by sim handle
+    std::map<int, StatusUpdate> mPendingStatus;
+    /// Sims whose GUI has fallen behind, keyed by sim handle
+    std::map<int, bool> mHistoryOnly;
+    /// Protects mPendingStatus and mHistoryOnly
+    mutable QMutex      mStatusMutex;
+    /// Number of waiting status messages at which a sim goes into
+    /// history-only mode
+    unsigned int        mHistoryOnlyDepth;
+    /// What the thread sleeps on between polls
+    CommsWaiter         mWaiter;
+    /// How we find out that an application has sent something
+    struct AppWatch {
+      /// Where its messages are passed on to
+      Application *mApp;
+      /// Connection descriptor, -1 if none
+      int mFd;
+      /// Its steering directory, empty if none
+      QString mSteerDir;
+      /// DirWatcher identifier for its steering directory, -1 if not
+      /// being watched
+      int mDirWatch;
+      /// Whether polling it has been paused
+      bool mPaused;
+    };
+    /// Start or stop watching an application's descriptor and
+    /// directory. mAppMutex must be held.
+    void watch(AppWatch &aWatch, const bool aOn);
+    /// Attached applications keyed by sim handle; once one has been
+    /// removed its Application is never touched again
+    std::map<int, AppWatch> mAppWatches;
+    /// Steering directories of Files transport applications
+    DirWatcher          mDirWatcher;
+    /// Protects mAppWatches and mDirWatcher, and is held while a
+    /// message is passed on to an Application so that it can't be
+    /// removed in the middle
+    mutable QMutex      mAppMutex;
 };
 
 #endif
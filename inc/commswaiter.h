@@ -0,0 +1,113 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file commswaiter.h
+ *  @brief Header file for the class the CommsThread sleeps on.
+ */
+
+#ifndef __COMMSWAITER_H__
+#define __COMMSWAITER_H__
+
+#include <set>
+#include <vector>
+#include <QMutex>
+#ifdef WIN32
+#include <QWaitCondition>
+#endif
+
+/// Lets the CommsThread block until either its polling interval has
+/// elapsed, one of the watched file descriptors has data to read, or
+/// another thread has asked it to wake up (stop, attach, etc).
+///
+/// On POSIX systems this is a poll() over a self-pipe plus the
+/// watched descriptors. On Windows there are no descriptors to watch
+/// and it falls back to a wait condition.
+/// @author Robert Haines
+class CommsWaiter {
+public:
+  CommsWaiter();
+  ~CommsWaiter();
+
+  /// Add a descriptor to the set that wait() blocks on.
+  void addDescriptor(const int aFd);
+  /// Remove a descriptor previously passed to addDescriptor().
+  void removeDescriptor(const int aFd);
+  /// Whether any descriptors (other than the wakeup pipe) are watched.
+  bool hasDescriptors() const;
+
+  /// Block for at most aTimeout milliseconds.
+  /// @param aWatchDescriptors If false only the timeout and wakeup()
+  /// end the wait, e.g. after a descriptor reported readiness that
+  /// turned out not to be a message (a peer that has hung up stays
+  /// readable for ever).
+  /// @return true if a watched descriptor became readable, false if
+  /// the timeout expired or wakeup() was called.
+  bool wait(const int aTimeout, const bool aWatchDescriptors = true);
+  /// Interrupt a wait() in progress, or make the next one return
+  /// immediately. Safe to call from any thread.
+  void wakeup();
+
+  /// The set of socket descriptors currently open in this process.
+  /// Comparing this before and after a library call that connects to
+  /// an application finds the descriptor that the connection uses -
+  /// the steering library does not otherwise expose it. Always empty
+  /// on Windows.
+  static std::set<int> openSockets();
+
+private:
+  mutable QMutex   mMutex;
+  std::vector<int> mFds;
+#ifndef WIN32
+  int              mPipe[2];
+#else
+  QWaitCondition   mCondition;
+  bool             mWoken;
+#endif
+};
+
+#endif // __COMMSWAITER_H__
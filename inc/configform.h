@@ -52,6 +52,7 @@
 #define __CONFIG_FORM_H__
 
 #include <qdialog.h>
+#include <qstring.h>
 
 class QLineEdit;
 class QPushButton;
@@ -61,7 +62,9 @@ class ConfigForm: public QDialog
   Q_OBJECT
 
 public:
-  ConfigForm(int aCurrentIntervalValue, QWidget *parent = 0, const char *name = "configform",
+  /// @param aWhat What the value is, for the prompt
+  ConfigForm(int aCurrentIntervalValue, const QString &aWhat = "interval",
+	     QWidget *parent = 0, const char *name = "configform",
 	     bool modal = TRUE, Qt::WFlags f = 0 );
   ~ConfigForm();
 
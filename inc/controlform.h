@@ -64,7 +64,9 @@
 #include <Q3HBoxLayout>
 #include <Q3PtrList>
 
+#include "historycache.h"
 #include "historyplot.h"
+#include "statusupdate.h"
 
 class QPushButton;
 class QString;
@@ -77,6 +79,7 @@ class SteeredParameterTable;
 class IOTypeTable;
 class TableLabel;
 class SteererMainWindow;
+class ReGExecutor;
 
 /// The widget that displays all information on a single application.
 /// We have one of these for each application being steered - they
@@ -91,17 +94,21 @@ class ControlForm : public QWidget
 public:
 
   ControlForm(QWidget *aParent, const char *aName, int aSimHandle,
-	      Application *aApplication, QMutex *aMutex);
+	      Application *aApplication, ReGExecutor *aExecutor);
   ~ControlForm();
-  /// Update the parameter details for this application
-  /// @param isStatusMsg Whether this update results from a status
-  /// message
-  void updateParameters(const bool isStatusMsg);
-  /// Update the IOType or ChkTypes for this application
-  void updateIOTypes(bool aChkPtType = false);
+  /// Update the parameters, IOTypes and ChkTypes for this
+  /// application from a snapshot taken by the CommsThread, logging
+  /// the values from any status messages it covers
+  void applyUpdate(const StatusUpdate &aUpdate);
   /// Called when application receives a parameter log message (i.e.
   /// log information for before the steering client attached)
   void updateParameterLog();
+  /// Get the whole history of each parameter by its label, for
+  /// saving to the HistoryCache
+  void getHistoryTimelines(HistoryCache::SeriesMap &aSeries);
+  /// Use the cached history of each parameter, now that the
+  /// HistoryCache has been loaded
+  void useCachedHistories();
 
   /// Disable all buttons on UI
   void disableAll(const bool aUnRegister = true);
@@ -147,8 +154,12 @@ public:
   void hideMonTable(bool flag);
 
 private:
-  void updateParameters(const bool aSteeredFlag,
-			const bool isStatusMsg);
+  /// Add rows for new parameters and update the values of the rest
+  /// @param aNewOnly Leave existing rows alone
+  void applyParameters(const std::vector<ParamState> &aParams,
+		       const bool aSteeredFlag, const bool aNewOnly = false);
+  void applyIOTypes(const std::vector<IOTypeState> &aTypes,
+		    const bool aChkPtType);
   void disableButtons();
 
 protected slots:
@@ -160,6 +171,8 @@ protected slots:
   void setCreateButtonStateSlot(const bool aEnable);
   void setConsumeButtonStateSlot(const bool aEnable);
   void setEmitButtonStateSlot(const bool aEnable);
+  /// Show the latest values held back in history-only mode
+  void redrawSlot();
 
 public slots:
   /// Slot called when the user quits a parameter history plot
@@ -214,8 +227,14 @@ private:
   /// Pointer to the label for the ParameterTable containing monitored params
   TableLabel            *mMonTableLabel;
 
-  /// Pointer to mutex protecting calls to ReG steer lib
-  QMutex                *mMutexPtr;
+  /// Pointer to the thread that makes all ReG steer lib calls
+  ReGExecutor           *mExecutor;
+
+  /// Whether redrawSlot() is due to show mLatestMonParams and
+  /// mLatestSteerParams
+  bool                   mRedrawPending;
+  std::vector<ParamState> mLatestMonParams;
+  std::vector<ParamState> mLatestSteerParams;
 
 public:
   /// List of the history plots associated with this application
@@ -0,0 +1,97 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file dirwatcher.h
+ *  @brief Header file for the class that watches steering directories.
+ */
+
+#ifndef __DIRWATCHER_H__
+#define __DIRWATCHER_H__
+
+#include <map>
+#include <QString>
+
+/// Watches the steering directories used by the Files transport so
+/// that the CommsThread can sleep until an application actually
+/// writes a message, rather than scanning each directory every
+/// polling interval.
+///
+/// This uses inotify and so is only available on Linux. Elsewhere,
+/// or if inotify cannot be initialised, every addDirectory() call
+/// fails and the caller should keep polling as before. Directories
+/// on network filesystems are refused too, as inotify does not see
+/// files written by other hosts.
+/// @author Robert Haines
+class DirWatcher {
+public:
+  DirWatcher();
+  ~DirWatcher();
+
+  /// The descriptor to wait on for readability, or -1 if nothing is
+  /// being watched.
+  int descriptor() const;
+
+  /// Start watching aDir for new files.
+  /// @return An identifier to pass to removeDirectory(), or -1 if the
+  /// directory cannot be watched.
+  int addDirectory(const QString &aDir);
+  /// Stop watching a directory. Watches are reference counted so
+  /// several applications can share a directory.
+  void removeDirectory(const int aWatch);
+
+  /// Read and discard all pending events without blocking.
+  /// @return true if any events were read.
+  bool drain();
+
+private:
+  int                 mFd;
+  /// Reference counts keyed by watch identifier
+  std::map<int, int>  mWatches;
+};
+
+#endif // __DIRWATCHER_H__
@@ -0,0 +1,142 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+/** @file historycache.h
+ *  @brief Header file for the on-disk cache of parameter histories
+ *  kept between attaches to an application.
+ */
+
+#ifndef __HISTORYCACHE_H__
+#define __HISTORYCACHE_H__
+
+#include <QString>
+#include <QThread>
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+class QObject;
+
+/// A file holding the parameter histories of one application, keyed
+/// by where the application is (its sim ID, or its steering directory
+/// with the Files transport), so that they can be shown again as soon
+/// as the steerer reattaches to it, even after a restart, without
+/// waiting for the whole log to be fetched from the application.
+///
+/// Each history is stored by the label of its parameter, since handles
+/// can change between attaches. All the histories in the file have a
+/// value for each row of the timeline that was saved, including
+/// SEQUENCE_NUM's, so they can be used as the log of a HistoryTable.
+/// Integer parameters are stored as integers so they stay exact. The
+/// values are compressed a segment at a time by SeriesCodec.
+///
+/// The file is replaced as a whole each time it is saved. A file that
+/// is for another application, another version or that is corrupt is
+/// ignored.
+/// @author Robert Haines
+class HistoryCache {
+public:
+  /// One parameter's history
+  struct Series {
+    Series() : mIsInteger(false) {}
+    /// Whether the values are in mIntegers rather than mValues
+    bool                 mIsInteger;
+    std::vector<double>  mValues;
+    /// The most negative integer means no value
+    std::vector<int64_t> mIntegers;
+  };
+  typedef std::map<QString, Series> SeriesMap;
+
+  /// Use the cache file for the application at aKey in the directory
+  /// aDir
+  HistoryCache(const QString &aDir, const QString &aKey);
+
+  /// Read the histories from the file, if there is one. This can take
+  /// a while so is best done by a HistoryCacheLoader.
+  /// @return false if there wasn't a usable one
+  bool load();
+  /// Take the history of the parameter with label aLabel that was
+  /// loaded, as doubles like a log, and forget it
+  /// @return false if there isn't one
+  bool take(const QString &aLabel, std::vector<double> &aValues);
+  /// Forget all of the histories that were loaded
+  void clear();
+
+  /// Replace the file with aSeries, which should all be the same
+  /// length. What was loaded is left alone.
+  /// @return false if it couldn't be written
+  bool save(const SeriesMap &aSeries) const;
+
+  /// The file the histories are kept in
+  QString getFileName() const;
+
+private:
+  QString   mFileName;
+  QString   mKey;
+  SeriesMap mSeries;
+};
+
+/// Loads a HistoryCache off the GUI thread, then posts an event to
+/// let the GUI know. Nothing else may use the cache until the event
+/// arrives or the thread has been waited for.
+/// @author Robert Haines
+class HistoryCacheLoader : public QThread {
+public:
+  /// @param aReceiver Where to post the event
+  /// @param aEventType The type of the event
+  HistoryCacheLoader(HistoryCache *aCache, QObject *aReceiver,
+		     const int aEventType);
+
+  virtual void run();
+
+private:
+  HistoryCache *mCache;
+  QObject      *mReceiver;
+  int           mEventType;
+};
+
+#endif // __HISTORYCACHE_H__
@@ -88,6 +88,8 @@ private:
     Q3PopupMenu *mGraphMenu;
     /// Pointer to ParameterHistory for abscissa
     ParameterHistory *mXParamHist;
+    /// The application being plotted, for tracing
+    int mSimHandle;
     /// The QwtPlot object for this history plot
     QwtPlot *mPlotter;
     /// Holds the label for the x axis
@@ -107,10 +109,6 @@ private:
     /// Hande of menu item for controlling whether lines are drawn
     int    mShowCurvesId;
 
-    /// Flag set when display options are changed by user - forces
-    /// both curves to be redrawn.
-    bool mForceHistRedraw;
-
     /// List of the sub-plots constituting this history plot
     Q3PtrList<HistorySubPlot> mSubPlotList;
 
@@ -161,13 +159,15 @@ public:
      *    for the wrong parameter signals
      *  @param yparamID Unique parameter ID so that we don't draw graphs
      *    for the wrong parameter signals
+     *  @param aSimHandle The application the parameters belong to
      */
     HistoryPlot(ParameterHistory *mXParamHist,
 		ParameterHistory *mYParamHist,
 		const char *lLabelx,
 		const char *lLabely,
 		const int xparamID, const int yparamID,
-		const char *_lComponentName);
+		const char *_lComponentName,
+		const int aSimHandle = -1);
     ~HistoryPlot();
 
     /** Add another plot/curve to this history plot */
@@ -0,0 +1,124 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file historyspool.h
+ *  @brief Header file for the file that parameter histories are
+ *  moved out to once they are no longer recent.
+ */
+
+#ifndef __HISTORYSPOOL_H__
+#define __HISTORYSPOOL_H__
+
+#include <QString>
+#include <vector>
+
+/// An append-only file that the parameter histories of one
+/// application are moved out to, so that only the most recent values
+/// of each parameter (the "hot window") are kept in memory. The file
+/// is made up of blocks, each holding one TypedSeries segment's worth
+/// of values for a single parameter, so every parameter's history is
+/// a column of blocks in the file. Blocks are as big as the type of
+/// the values needs.
+///
+/// If compressing, each block is a segment compressed by SeriesCodec
+/// rather than the raw values, so blocks vary in size. If there is
+/// no file to put them in the TypedSeries keep the compressed blocks
+/// in memory instead.
+///
+/// The file is memory-mapped a large extent at a time for reading, so
+/// values that have been moved out stay where they are for the life
+/// of the spool and the kernel decides how much of it to keep in RAM.
+/// The file is removed as soon as it is created so nothing is left
+/// behind, however the steerer exits.
+///
+/// Only available where mmap is; elsewhere isOpen() is always false
+/// and the histories just stay in memory (compressed if asked).
+/// @author Robert Haines
+class HistorySpool {
+public:
+  /// Create a spool file in the directory aDir
+  /// @param aSimHandle The application whose histories it will hold
+  /// @param aHotValues How many of the most recent values of each
+  /// parameter to keep in memory
+  /// @param aCompress Whether to compress the values that are moved
+  /// out of the hot window
+  HistorySpool(const QString &aDir, const int aSimHandle,
+	       const int aHotValues, const bool aCompress = false);
+  ~HistorySpool();
+
+  /// Whether values can be moved out to the file
+  bool isOpen() const;
+  /// Whether values moved out of the hot window are compressed
+  bool isCompressing() const;
+  /// How many of the most recent segments of each parameter to keep
+  /// in memory
+  int getHotSegments() const;
+
+  /// Append a block of aBytes bytes, a full segment of values or a
+  /// compressed one, to the file
+  /// @return where the block can be read from now, or NULL if it
+  /// couldn't be written
+  const char *write(const char *aData, const size_t aBytes);
+
+private:
+  // not copyable - the file and maps are owned
+  HistorySpool(const HistorySpool &);
+  HistorySpool &operator=(const HistorySpool &);
+
+  const char *mapExtent(const unsigned int aExtent);
+
+  int                 mFile;
+  int                 mHotSegments;
+  bool                mCompress;
+  /// Number of bytes of the file used so far
+  qint64              mUsed;
+  /// The extents of the file that have been mapped so far, in order
+  std::vector<char *> mExtents;
+};
+
+#endif // __HISTORYSPOOL_H__
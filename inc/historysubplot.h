@@ -53,11 +53,65 @@
 
 #include <qwt_plot.h>
 #include <qwt_plot_curve.h>
+#include <qwt_data.h>
 
+#include <vector>
+
+#include "historytiers.h"
 #include "parameterhistory.h"
 
 class HistoryPlot;
 
+/** Lets a curve show the values held in a pair of SeriesStores
+ *  without copying them. Only aSize points are shown, starting at
+ *  aXStart in aX and aYStart in aY, so more values can be added to
+ *  the stores in the meantime.
+ *
+ *  Older values that have been dropped can be shown before them by
+ *  their summaries: a pair of points, at the smallest and largest
+ *  value, for each bucket of HistoryTiers. Before those come the
+ *  values from the log of before attaching, if both have one, so the
+ *  whole history is a single series.
+ *
+ *  If made by aligned(), the bounds for autoscaling come from the
+ *  parameters' HistoryTiers rather than looking at every point.
+ */
+class SeriesData : public QwtData
+{
+public:
+    SeriesData(const SeriesStore *aX, const int aXStart,
+	       const SeriesStore *aY, const int aYStart,
+	       const size_t aSize);
+    /// The values of two parameters that were logged at the same
+    /// time
+    static SeriesData aligned(const ParameterHistory *aX,
+			      const ParameterHistory *aY);
+
+    /// Show the summaries of rows aFrom to aTo first
+    void addSummaries(const HistoryTiers &aX, const HistoryTiers &aY,
+		      const int aFrom, const int aTo);
+
+    virtual QwtData *copy() const;
+    virtual size_t size() const;
+    virtual double x(size_t i) const;
+    virtual double y(size_t i) const;
+    virtual QwtDoubleRect boundingRect() const;
+
+private:
+    /// Where the values came from, if known
+    const ParameterHistory *mXHist;
+    const ParameterHistory *mYHist;
+    /// Number of points from the log at the start
+    int                 mNumLog;
+    std::vector<double> mSummaryX;
+    std::vector<double> mSummaryY;
+    const SeriesStore *mX;
+    int                mXStart;
+    const SeriesStore *mY;
+    int                mYStart;
+    size_t             mSize;
+};
+
 /** The historysubplot class deals with the plotting of a single
  *  curve on a historyplot (which may consist of more than one
  *  such curve).
@@ -80,18 +134,10 @@ private:
     /// Holds the label for the y axis or key
     QString           mLabely;
 
-    /// The curve showing the history of the
-    /// parameter prior to the time the steerer connected
-    QwtPlotCurve* mHistCurve;
-
-    /// The curve showing the history of the parameter
-    /// we are looking after since the steerer connected to the simulation
+    /// The curve showing the history of the parameter, from
+    /// before and since the steerer connected to the simulation
     QwtPlotCurve* mCurve;
 
-    /// How many elements the log for the parameter being plotted
-    /// used to have
-    int     mPreviousLogSize;
-
     /// String holding the (QColor-recognised) name of the colour
     /// of the pen for this curve
     QString mColour;
@@ -107,7 +153,7 @@ public:
     ~HistorySubPlot();
 
     /// Wipe and (re)draw the graph
-    void doPlot(bool lForceHistRedraw);
+    void doPlot();
     /// Called by updateSlot in HistoryPlot
     void update();
     void filePrint();
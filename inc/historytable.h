@@ -0,0 +1,249 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file historytable.h
+ *  @brief Header file for the table of values logged from an
+ *  application's status messages.
+ */
+
+#ifndef __HISTORYTABLE_H__
+#define __HISTORYTABLE_H__
+
+#include <map>
+#include <utility>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "historytiers.h"
+#include "typedseries.h"
+#include "statusupdate.h"
+
+class HistorySpool;
+
+/// The values logged from one application's status messages, stored
+/// a column per parameter. Each status appends one row: its sequence
+/// number and the value of every logged parameter, so the columns
+/// always line up and any parameter can be plotted or exported
+/// against any other by scanning the columns together.
+///
+/// A parameter that first appears part way through only has values
+/// from then on; rows before that, and rows from statuses that didn't
+/// include it, read as NaN.
+///
+/// The logs of values from before the steerer attached are spliced in
+/// front of the rows by sequence number. There can be two of each
+/// parameter's log: one fetched from the steering library and one
+/// cached from an earlier attach. Each is lined up by the SEQUENCE_NUM
+/// log from the same place, so the two needn't be the same length, and
+/// where both have a sequence number the fetched value is used. Only
+/// log rows from before the first status, and only the first of any
+/// with the same sequence number, are used. Together they give one
+/// timeline of log rows followed by rows.
+///
+/// Each column also keeps HistoryTiers of its values. If only a
+/// number of the latest rows are to be retained, older values are
+/// dropped and only the tiers are left to show them.
+/// @author Robert Haines
+class HistoryTable {
+public:
+  HistoryTable();
+  ~HistoryTable();
+
+  /// Spool old values of all of the columns to aSpool
+  void setSpool(const boost::shared_ptr<HistorySpool> &aSpool);
+  /// Keep only about the latest aRows rows of values, or all of them
+  /// if 0. Should be set before anything is logged.
+  void setRetainedRows(const int aRows);
+
+  /// Add a row for a status message
+  void append(const StatusRecord &aRecord);
+
+  /// Number of rows (statuses) logged
+  int getNumRows() const;
+  /// The sequence number of each row
+  const SeriesStore &getSeqNums() const;
+
+  /// The handles of all of the parameters logged so far, in order
+  std::vector<int> getHandles() const;
+  /// The values logged for a parameter, starting at row
+  /// getFirstRow(aHandle), or NULL if none have been
+  const SeriesStore *getColumn(const int aHandle) const;
+  /// The row of the first value in a parameter's column
+  int getFirstRow(const int aHandle) const;
+  /// The row of the first value in a parameter's column that hasn't
+  /// been dropped
+  int getFirstKeptRow(const int aHandle) const;
+  /// The summaries of a parameter's values, or NULL if none have been
+  /// logged
+  const HistoryTiers *getTiers(const int aHandle) const;
+  /// A parameter's value in a row, or NaN if it wasn't logged
+  double getValue(const int aHandle, const int aRow) const;
+  /// A parameter's value in a row as an integer, exactly if
+  /// holdsIntegers(aHandle)
+  /// @return false if it wasn't logged
+  bool getInt64Value(const int aHandle, const int aRow,
+		     int64_t &aValue) const;
+  /// Whether a parameter's values are held as integers
+  bool holdsIntegers(const int aHandle) const;
+  /// The values of every parameter in a row, in the order given by
+  /// getHandles()
+  void getRow(const int aRow, std::vector<double> &aValues) const;
+
+  /// The smallest, largest, mean and last of a parameter's values in
+  /// rows aFrom up to aTo, read mostly from its HistoryTiers
+  HistoryTiers::Bucket getSummary(const int aHandle, const int aFrom,
+				  const int aTo) const;
+  /// The first row with a sequence number of at least aSeqNum, or
+  /// getNumRows() if there isn't one. Sequence numbers are assumed
+  /// not to go down; rows that have been dropped can't be found.
+  int findRow(const int aSeqNum) const;
+
+  /// Use the log of a parameter's values from before attaching, as
+  /// fetched from the steering library, which still owns aValues
+  void setLog(const int aHandle, const double *aValues, const int aSize);
+  /// Use the log of a parameter's values from an earlier attach, as
+  /// cached by a HistoryCache. The values are taken from aValues.
+  /// Once the fetched logs have all of its sequence numbers it is
+  /// freed.
+  void setCachedLog(const int aHandle, std::vector<double> &aValues);
+  /// Which parameter's log holds the sequence numbers to splice the
+  /// logs in by. Without it the logs are used as they are, the fetched
+  /// ones if there are any and the cached ones if not.
+  void setSeqNumHandle(const int aHandle);
+  /// Whether a parameter has a log
+  bool hasLog(const int aHandle) const;
+  /// Number of log rows that come before the first row
+  int getNumLogRows() const;
+  /// A parameter's value in a log row, or NaN if it hasn't got one
+  double getLogValue(const int aHandle, const int aLogRow) const;
+  /// The smallest, largest, mean and last of a parameter's values in
+  /// all of the log rows
+  HistoryTiers::Bucket getLogSummary(const int aHandle) const;
+  /// A parameter's value in every log row, then the last value in
+  /// each bucket of the tiers covering the rows whose values have been
+  /// dropped, then the value in every row that is still kept. This is
+  /// the same number of values for every parameter, so that they can
+  /// be used as logs again. Dropped rows that share the finest bucket
+  /// left covering them with kept rows are left out.
+  void getTimeline(const int aHandle, std::vector<double> &aValues) const;
+  /// As above, but with the values as integers, exactly if
+  /// holdsIntegers(aHandle). No value is the most negative integer.
+  void getTimeline(const int aHandle, std::vector<int64_t> &aValues) const;
+
+private:
+  // not copyable - the columns are owned
+  HistoryTable(const HistoryTable &);
+  HistoryTable &operator=(const HistoryTable &);
+
+  struct Column {
+    Column(const int aFirstRow, const int aType)
+      : mFirstRow(aFirstRow), mValues(SeriesStore::create(aType)) {}
+    ~Column() { delete mValues; }
+    int          mFirstRow;
+    /// Held as the parameter's type
+    SeriesStore *mValues;
+    HistoryTiers mTiers;
+  };
+
+  /// Where a log came from. Where logs from both have a value for a
+  /// log row, the fetched one is used.
+  enum LogSource { kFETCHED_LOG, kCACHED_LOG, kNUM_LOG_SOURCES };
+
+  struct Log {
+    Log() : mValues(NULL), mSize(0) {}
+    const double        *mValues;
+    int                  mSize;
+    /// The values, if they are ours
+    std::vector<double>  mOwned;
+  };
+
+  /// Drop the values in rows before aRow
+  void release(const int aRow);
+  /// The finest tier that still covers dropped row aRow in every
+  /// column
+  int getTimelineTier(const int aRow) const;
+  /// The ends of the runs of dropped rows that getTimeline() puts a
+  /// row in for
+  void getDroppedRuns(std::vector<int> &aEnds) const;
+  /// Put a log in, and splice the logs again if need be
+  void updateLog(const int aHandle, const LogSource aSource);
+  /// Work out which entries of the logs are log rows
+  void spliceLogs();
+  /// The sequence numbers in a source's SEQUENCE_NUM log that can be
+  /// log rows, in order, with the index of each
+  void getLogSeqNums(const int aSource,
+		     std::vector<std::pair<double, int> > &aSeqNums) const;
+  /// A parameter's log from a source, or NULL if it hasn't got one
+  const Log *findLog(const int aSource, const int aHandle) const;
+  void summariseLog(const int aHandle);
+  /// Free a parameter's cached log if the fetched one has all of the
+  /// log rows it has
+  void dropCachedLog(const int aHandle);
+
+  TypedSeries<int64_t>            mSeqNums;
+  /// Keyed by parameter handle
+  std::map<int, Column *>         mColumns;
+  boost::shared_ptr<HistorySpool> mSpool;
+  /// How many rows to keep the values of, or 0 for all
+  int                             mRetainedRows;
+  /// The sequence number of the first row
+  int                             mFirstSeqNum;
+  /// Keyed by parameter handle, for each source
+  std::map<int, Log>              mLogs[kNUM_LOG_SOURCES];
+  int                             mSeqNumHandle;
+  /// Whether the logs are spliced in by sequence number rather than
+  /// used as they are
+  bool                            mLogsBySeqNum;
+  int                             mNumLogRows;
+  /// For each source, the index in its logs of each log row, or -1
+  std::vector<int>                mLogRows[kNUM_LOG_SOURCES];
+  /// Keyed by parameter handle
+  std::map<int, HistoryTiers::Bucket> mLogSummaries;
+};
+
+#endif // __HISTORYTABLE_H__
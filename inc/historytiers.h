@@ -0,0 +1,145 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file historytiers.h
+ *  @brief Header file for coarse summaries of a parameter's history.
+ */
+
+#ifndef __HISTORYTIERS_H__
+#define __HISTORYTIERS_H__
+
+#include <deque>
+
+class SeriesStore;
+
+/// Summaries of one column of a HistoryTable at coarser and coarser
+/// resolutions, so that a long history can still be shown once its
+/// oldest values have been dropped. Tier 0 has a bucket for every 64
+/// rows of the table, tier 1 one for every 64 of those, and so on.
+/// Each bucket keeps the smallest, largest, mean and last of the
+/// values in it so a spike is never lost, however coarse the tier.
+///
+/// Buckets line up with the rows of the table rather than with the
+/// values of the column, so the same bucket of any two columns
+/// covers the same statuses and they can be plotted against each
+/// other. Every value updates one bucket in each tier, so keeping the
+/// tiers up to date costs the same however long the history is.
+///
+/// The tiers also form a tree over the values, so the summary of any
+/// run of rows can be put together from a few buckets of each tier
+/// plus the odd value at either end, rather than by reading every
+/// value in it.
+///
+/// All but the coarsest tier can be limited to their most recent
+/// buckets; what they no longer cover is still in the tiers above.
+/// @author Robert Haines
+class HistoryTiers {
+public:
+  /// Each bucket covers 2^kTIER_BITS buckets of the tier below
+  static const int kTIER_BITS = 6;
+  static const int kNUM_TIERS = 4;
+
+  /// Summary of the values in a run of rows. NaNs (rows the
+  /// parameter wasn't logged in) are left out.
+  struct Bucket {
+    Bucket();
+    void add(const double aValue);
+    /// Add the values in aOther, which come after these
+    void add(const Bucket &aOther);
+    double getMean() const;
+
+    double mMin;
+    double mMax;
+    double mSum;
+    double mLast;
+    /// Number of values that aren't NaN
+    int    mCount;
+  };
+
+  HistoryTiers();
+
+  /// Keep at most aBuckets buckets in each tier but the coarsest, or
+  /// all of them if 0
+  void setRetained(const int aBuckets);
+  /// Add the value in row aRow; rows must be added in order
+  void append(const int aRow, const double aValue);
+  void clear();
+
+  /// The number of rows each bucket in aTier covers
+  static int getBucketRows(const int aTier);
+  /// The first bucket still kept in aTier. Bucket i covers rows
+  /// i * getBucketRows(aTier) onwards.
+  int getFirstBucket(const int aTier) const;
+  /// One past the last bucket in aTier
+  int getEndBucket(const int aTier) const;
+  /// Bucket aBucket of aTier, which must be one that is kept
+  const Bucket &getBucket(const int aTier, const int aBucket) const;
+  /// The finest tier that still has the bucket covering aRow, or -1
+  /// if none do
+  int getFinestTier(const int aRow) const;
+  /// Summarise the values in rows aFrom up to aTo
+  /// @param aValues The column of values that the tiers are of
+  /// @param aFirstRow The row of the first value in aValues
+  /// @return The exact summary if all of the values are still kept,
+  /// otherwise the buckets covering the ones that have been dropped
+  /// are used whole
+  Bucket summarise(const SeriesStore &aValues, const int aFirstRow,
+		   const int aFrom, const int aTo) const;
+
+private:
+  struct Tier {
+    Tier() : mFirst(0) {}
+    int                mFirst;
+    std::deque<Bucket> mBuckets;
+  };
+
+  Tier mTiers[kNUM_TIERS];
+  int  mRetained;
+};
+
+#endif // __HISTORYTIERS_H__
@@ -55,20 +55,21 @@
 #define __IOTYPE_TABLE_H__
 
 #include <qpoint.h>
-#include <qmutex.h>
 //Added by qt3to4:
 #include <Q3PtrList>
 
 #include "iotype.h"
 #include "table.h"
 
+class ReGExecutor;
+
 class IOTypeTable : public Table
 {
   Q_OBJECT
 
 public:
   IOTypeTable(QWidget *aParent, const char *aName, int aSimHandle,
-	      QMutex *aMutex, bool aChkPtType = false);
+	      ReGExecutor *aExecutor, bool aChkPtType = false);
   ~IOTypeTable();
 
   virtual void initTable();
@@ -123,8 +124,8 @@ private:
   bool	    mChkPtTypeFlag;
   int	    mRestartRowIndex;
   int       mRestartRowIndexNew;
-  /// Ptr to mutex protecting calls to ReG steer lib
-  QMutex   *mMutexPtr;
+  /// Ptr to the thread that makes all ReG steer lib calls
+  ReGExecutor *mExecutor;
 };
 
 
@@ -0,0 +1,94 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file latencyhistogram.h
+ *  @brief Header file for a compact histogram of latencies.
+ */
+
+#ifndef __LATENCYHISTOGRAM_H__
+#define __LATENCYHISTOGRAM_H__
+
+#include <vector>
+#include <stdint.h>
+
+/// A histogram of latencies in microseconds with log-linear buckets
+/// in the style of HdrHistogram: each power of two is split into
+/// eight equal buckets, so any value is known to within 12.5% while
+/// the whole range up to about 12 days fits in a few hundred
+/// counters. Not thread-safe.
+/// @author Robert Haines
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+
+  /// Add a sample
+  void record(const int64_t aMicros);
+  /// Add all of the samples in another histogram
+  void add(const LatencyHistogram &aOther);
+  /// Forget all samples
+  void reset();
+
+  unsigned long getCount() const;
+  int64_t getMax() const;
+  double getMean() const;
+  /// The value that aPercent percent of the samples are at or below,
+  /// to within the precision of the buckets
+  int64_t getPercentile(const double aPercent) const;
+
+private:
+  static unsigned int bucketIndex(const int64_t aMicros);
+  /// The largest value that falls in a bucket
+  static int64_t bucketTop(const unsigned int aIndex);
+
+  std::vector<unsigned long> mCounts;
+  unsigned long              mCount;
+  int64_t                    mMax;
+  double                     mSum;
+};
+
+#endif // __LATENCYHISTOGRAM_H__
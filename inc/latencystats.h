@@ -0,0 +1,141 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file latencystats.h
+ *  @brief Header file for the latencies of messages on their way
+ *  from the steering library to the GUI.
+ */
+
+#ifndef __LATENCYSTATS_H__
+#define __LATENCYSTATS_H__
+
+#include <map>
+#include <utility>
+#include <QMutex>
+#include <QString>
+#include <lunchbox/clock.h>
+
+#include "latencyhistogram.h"
+
+/// Collects how long messages spend in each stage of the receive
+/// path, with a LatencyHistogram per application, message type and
+/// stage. The stages are:
+///  - consume: Get_next_message returning to the Consume_* call
+///    finishing;
+///  - queue: from there to being queued for the Application;
+///  - dispatch: waiting in the queue for the GUI thread;
+///  - display: the GUI thread processing it (updating the tables);
+///  - total: Get_next_message returning to the end of display.
+///
+/// Status messages that are merged into one already waiting for the
+/// GUI are only seen by the consume stage, so its count can be higher
+/// than the others'. Thread-safe.
+/// @author Robert Haines
+class LatencyStats {
+public:
+  enum Stage {
+    kCONSUME = 0,
+    kQUEUE,
+    kDISPATCH,
+    kDISPLAY,
+    kTOTAL,
+    kNUM_STAGES
+  };
+
+  /// When a message reached each stage (microseconds from now()), or
+  /// -1 if it hasn't
+  struct Stamps {
+    Stamps() : mReceived(-1), mConsumed(-1), mQueued(-1),
+	       mDispatched(-1), mShown(-1) {}
+    int64_t mReceived;
+    int64_t mConsumed;
+    int64_t mQueued;
+    int64_t mDispatched;
+    int64_t mShown;
+  };
+
+  LatencyStats();
+
+  /// The time to use for Stamps, in microseconds. Can be called from
+  /// any thread.
+  int64_t now() const;
+
+  /// Record the stages that a message has passed through
+  void record(const int aSimHandle, const int aMsgType,
+	      const Stamps &aStamps);
+  /// Forget everything recorded so far
+  void reset();
+
+  /// The percentiles for every application, message type and stage
+  /// as a table
+  QString getReport() const;
+  /// Write the report to a file.
+  /// @return false if the file couldn't be written
+  bool dump(const QString &aFileName) const;
+
+  /// A readable name for a message type
+  static QString msgTypeName(const int aMsgType);
+  /// A readable name for a stage
+  static QString stageName(const Stage aStage);
+
+private:
+  void add(const int aSimHandle, const int aMsgType, const Stage aStage,
+	   const int64_t aFrom, const int64_t aTo);
+
+  typedef std::pair<int, int> Key;
+  struct Entry {
+    LatencyHistogram mStages[kNUM_STAGES];
+  };
+
+  mutable QMutex        mMutex;
+  lunchbox::Clock       mClock;
+  /// Keyed by sim handle and message type
+  std::map<Key, Entry>  mEntries;
+};
+
+#endif // __LATENCYSTATS_H__
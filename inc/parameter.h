@@ -57,6 +57,7 @@
 #include <qstring.h>
 
 #include "parameterhistory.h"
+#include "paramvalue.h"
 
 class Q3Table;
 
@@ -100,7 +101,14 @@ public:
   void setIndex(int aIndex);
   void unRegister();
 
+  /// Set the limits of the parameter, "--" meaning none
   void setMinMaxStrings(const char *min, const char *max);
+  /// Whether aValue is within the parameter's limits
+  bool inRange(const ParamValue &aValue) const;
+  /// Set the current value of the parameter
+  void setValue(const ParamValue &aValue);
+  /// Get the current value of the parameter
+  const ParamValue &getValue() const;
   /// Return string containing minimum value of parameter
   QString getMinString();
   /// Return string containing maximum value of parameter
@@ -132,6 +140,11 @@ private:
   QString mMinStr;
   /// Maximum value of this parameter (if any)
   QString mMaxStr;
+  /// mMinStr and mMaxStr parsed; not numbers if there is no limit
+  ParamValue mMin;
+  ParamValue mMax;
+  /// The latest value of this parameter
+  ParamValue mValue;
   /// The label given this parameter by the application code
   QString mLabel;
 };
@@ -51,7 +51,14 @@
 #ifndef __PARAMETERHISTORY_H__
 #define __PARAMETERHISTORY_H__
 
-/// @brief Class providing storage and accessors for logged parameter data.
+#include "historytiers.h"
+#include "seriesstore.h"
+
+class HistoryTable;
+
+/// @brief Class providing accessors for logged parameter data.
+/// The values logged since attaching are held in the application's
+/// HistoryTable; this gives a view of one parameter's column.
 /// Used by the history plotting code.
 /// @see HistoryPlot
 /// @see HistorySubPlot
@@ -62,29 +69,57 @@ class ParameterHistory {
   public:
     ParameterHistory();
     ~ParameterHistory();
-    /// Store the supplied value in mParamHistArray (append)
-    void          updateParameter(const char* lVal);
-    /// Returns the value of the element at index in mParamHistArray
+    /// Show the values logged for parameter aHandle in aTable
+    void          setTable(const HistoryTable *aTable, const int aHandle);
+    /// Returns the table the values are logged in, if any
+    const HistoryTable *getTable() const;
+    /// Returns the value of the element at index in getValues()
     const float   elementAt(int index);
-    /// Returns mParamHistArray
-    double*       ptrToArray();
-
-    /// Size of array pointed to by mParamHistArray
-    int     mArraySize;
-    /// Position at which to insert next new value in array pointed
-    /// to by mParamHistArray
-    int     mArrayPos;
-    /// Pointer to array holding data logged by the steering library
-    /// _before_ steering client attached
-    double *mPtrPreviousHistArray;
-    /// Size of array pointed to by mPtrPreviousHistArray
-    int     mPreviousHistArraySize;
+    /// Returns the values we've logged since being attached, starting
+    /// at row getFirstRow() of the table
+    const SeriesStore &getValues() const;
+    /// Returns the number of values we've logged since being attached
+    int           getNumValues() const;
+    /// Returns the row of the table that the values start at
+    int           getFirstRow() const;
+    /// Returns the row of the first value that hasn't been dropped,
+    /// so is still in getValues()
+    int           getFirstKeptRow() const;
+    /// Returns the summaries of the values, which are all that is
+    /// left of ones that have been dropped, or NULL if there aren't
+    /// any
+    const HistoryTiers *getTiers() const;
+    /// Returns the smallest, largest, mean and last of the values at
+    /// index aFirst up to aEnd in getValues()
+    HistoryTiers::Bucket getSummary(const int aFirst, const int aEnd) const;
+    /// Returns the smallest, largest, mean and last of the values
+    /// logged with sequence numbers aFrom to aTo inclusive
+    HistoryTiers::Bucket getSummaryBySeqNum(const int aFrom,
+					    const int aTo) const;
+    /// Returns the value in a row of the table, or NaN if there isn't
+    /// one
+    double        valueAtRow(const int aRow) const;
+    /// Returns whether the values are held as integers
+    bool          holdsIntegers() const;
+    /// Gets the value in a row of the table as an integer, exactly if
+    /// holdsIntegers(). Returns false if there isn't one.
+    bool          int64AtRow(const int aRow, int64_t &aValue) const;
+
+    /// Returns the number of values from the log of data logged by
+    /// the steering library _before_ steering client attached that
+    /// come before the values in the table
+    int           getNumLogValues() const;
+    /// Returns the value in a log row of the table
+    double        logValueAt(const int aLogRow) const;
+    /// Returns the smallest, largest, mean and last of the values from
+    /// the log
+    HistoryTiers::Bucket getLogSummary() const;
 
  private:
-    /// Used when realloc'ing memory for the mParamHistArray
-    int     mArrayChunkSize;
-    /// Array holding data that we've logged since being attached
-    double *mParamHistArray;
+    /// Table holding data that we've logged since being attached
+    const HistoryTable *mTable;
+    /// Handle of the parameter in mTable
+    int     mHandle;
 };
 
 #endif
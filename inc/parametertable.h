@@ -63,8 +63,10 @@
 #include "parameter.h"
 #include "historyplot.h"
 #include "controlform.h"
+#include "historycache.h"
 
 class QEvent;
+class ReGExecutor;
 
 class ParameterTable : public Table
 {
@@ -72,7 +74,7 @@ class ParameterTable : public Table
 
 public:
   ParameterTable(QWidget *aParent, const char *aName, int aSimHandle,
-		 QMutex *aMutex);
+		 ReGExecutor *aExecutor);
   virtual ~ParameterTable();
 
   virtual void initTable();
@@ -80,22 +82,24 @@ public:
   /// Update the information shown in an existing row in the
   /// parameter table
   /// @param lHandle The handle of the parameter to update
-  /// @param lVal The value of the parameter (as a char*)
-  /// @param isStatusMsg Whether this update has been forced by receipt
-  /// of a status message
-  virtual bool updateRow(const int lHandle,
-			 const char *lVal,
-			 const bool isStatusMsg);
+  /// @param aValue The value of the parameter
+  virtual bool updateRow(const int lHandle, const ParamValue &aValue);
   /// Add a row to the parameter table
   /// @param lHandle The handle of the parameter to add a row for
   /// @param lLabel The label of this parameter
-  /// @param lVal The value of the parameter (as a char*)
+  /// @param aValue The value of the parameter
   /// @param lType The type of this parameter encoded as an int
   virtual void addRow(const int lHandle, const char *lLabel,
-		      const char *lVal, const int lType);
+		      const ParamValue &aValue, const int lType);
   /// Update the full log of the parameter values (i.e. for the
   /// period before the steering client attached)
   void updateParameterLog();
+  /// Add the whole history of each parameter in the table to aSeries
+  /// by its label
+  void getHistoryTimelines(HistoryCache::SeriesMap &aSeries);
+  /// Use the cached history of each parameter in the table, now that
+  /// the cache has been loaded
+  void useCachedHistories();
   /// Get a ptr to Parameter from its handle
   /// @param aId The handle of the parameter to look up
   Parameter *findParameter(int aId);
@@ -118,12 +122,18 @@ protected:
   Parameter *findParameterHandleFromRow(int row);
   /// Lookup Parameter from its label
   Parameter *findParameterFromLabel(const QString &aLabel);
+  /// Point the history of a new parameter at its column of the
+  /// application's HistoryTable
+  void attachHistory(Parameter *aParam);
+  /// Use the cached history of a parameter, if the cache has been
+  /// loaded and has one
+  void useCachedHistory(Parameter *aParam);
   /// List of the parameters associated with this application
   Q3PtrList<Parameter>   mParamList;
   /// Pointer to table of monitored parameters
   ParameterTable       *mMonParamTable;
-  /// Pointer to mutex used to control calls to steering library
-  QMutex               *mMutexPtr;
+  /// Pointer to the thread that makes all steering library calls
+  ReGExecutor          *mExecutor;
 
  private:
   /// Pointer to our parent control form
@@ -138,14 +148,14 @@ class SteeredParameterTable : public ParameterTable
 public:
   SteeredParameterTable(QWidget *aParent, const char *aName,
 			ParameterTable *aTable, int aSimHandle,
-			QMutex *aMutex);
+			ReGExecutor *aExecutor);
   virtual ~SteeredParameterTable();
 
   virtual void initTable();
   virtual void clearAndDisableForDetach(const bool aUnRegister = true);
 
   ////  virtual bool updateRow no redefinition required
-  virtual void addRow(const int lHandle, const char *lLabel, const char *lVal, const int lType, const char *lMinVal, const char *lMaxVal);
+  virtual void addRow(const int lHandle, const char *lLabel, const ParamValue &aValue, const int lType, const char *lMinVal, const char *lMaxVal);
 
   int setNewParamValuesInLib();
   void clearNewValues();
@@ -0,0 +1,112 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file paramvalue.h
+ *  @brief Header file for parameter values parsed according to their
+ *  type.
+ */
+
+#ifndef __PARAMVALUE_H__
+#define __PARAMVALUE_H__
+
+#include <QString>
+#include <stdint.h>
+
+/// The value of a parameter parsed once, according to its type, so
+/// that the tables, the history and the validation of new values can
+/// all use it without going back to the string. Numbers are parsed
+/// the way the steering library writes them, regardless of locale.
+/// @author Robert Haines
+class ParamValue {
+public:
+  ParamValue();
+
+  /// Parse a value
+  /// @param aType The REG_* type of the parameter
+  /// @param aText The value as a string
+  void parse(const int aType, const char *aText);
+
+  /// The REG_* type the value was parsed as
+  int getType() const;
+  /// Whether the value is a number that parsed
+  bool isNumber() const;
+  /// The value as an integer (REG_INT only)
+  int64_t toInt64() const;
+  /// The value as a double (any numeric type)
+  double toDouble() const;
+  /// The value to show in a table. Floating point numbers are
+  /// reformatted to lose excessive decimal places.
+  QString toString() const;
+
+  /// Whether two values would look the same
+  bool operator==(const ParamValue &aOther) const;
+  bool operator!=(const ParamValue &aOther) const {
+    return !(*this == aOther);
+  }
+
+  /// Parse a floating point number, ignoring the locale. Leading and
+  /// trailing spaces are allowed but nothing else.
+  /// @return false if aText isn't a number
+  static bool parseDouble(const char *aText, double &aValue);
+  /// Parse an integer. Leading and trailing spaces are allowed but
+  /// nothing else.
+  /// @return false if aText isn't an integer or doesn't fit in an
+  /// int64_t. The most negative int64_t isn't allowed either as the
+  /// histories use it for a missing value.
+  static bool parseInt(const char *aText, int64_t &aValue);
+
+private:
+  int     mType;
+  bool    mIsNumber;
+  int64_t mInt;
+  double  mDouble;
+  /// The string for strings, and for numbers that didn't parse
+  QString mText;
+};
+
+#endif // __PARAMVALUE_H__
@@ -0,0 +1,194 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file pollscheduler.h
+ *  @brief Header file for the per-application polling scheduler.
+ */
+
+#ifndef __POLLSCHEDULER_H__
+#define __POLLSCHEDULER_H__
+
+#include <map>
+#include <queue>
+#include <vector>
+#include <QMutex>
+#include <lunchbox/clock.h>
+
+/// Decides when the CommsThread next needs to look for messages.
+///
+/// Each attached application has its own polling interval and
+/// next-due time so a chatty application is polled quickly without
+/// dragging idle ones along. The due times are kept in a priority
+/// queue and the thread sleeps until the earliest of them.
+///
+/// With automatic adjustment on, the interval comes from a latency
+/// target and a smoothed (EWMA) estimate of the time between an
+/// application's status messages and of its jitter. Between
+/// messages the application isn't polled until shortly before the
+/// next one is expected; from then on it is polled every latency
+/// target until one turns up. A larger target therefore costs less
+/// CPU and a smaller one gets the messages to the GUI sooner.
+///
+/// The steering library checks every application in one call to
+/// Get_next_message, so a poll for one application is a poll for
+/// all of them - every application that is due (plus whichever one
+/// answered) is credited with the poll. Thread-safe.
+/// @author Robert Haines
+class PollScheduler {
+public:
+  /// What the scheduler currently knows about an application
+  struct AppStats {
+    /// The delay before the next poll (milliseconds)
+    int   mInterval;
+    /// Smoothed fraction of polls that found a message
+    float mHitRatio;
+    /// Smoothed time between status messages (milliseconds), or
+    /// negative if not known yet
+    float mMeanGap;
+  };
+
+  PollScheduler(const int aInterval, const int aLatencyTarget);
+
+  /// Start scheduling an application. It is due straight away.
+  void addApplication(const int aSimHandle);
+  /// Stop scheduling an application.
+  void removeApplication(const int aSimHandle);
+  /// Stop or start polling an application. A paused application is
+  /// never due, though its messages are still read whenever the
+  /// others are polled. It is due straight away once unpaused.
+  void setPaused(const int aSimHandle, const bool aPaused);
+
+  /// Record the result of the first call to Get_next_message after
+  /// a sleep, which polled every application that was due.
+  /// @param aSimHandle The handle it returned, or
+  /// REG_SIM_HANDLE_NOTSET if there was no message.
+  /// @param aMsgType The message type it returned.
+  void recordPoll(const int aSimHandle, const int aMsgType);
+  /// Record a message returned by any call to Get_next_message, so
+  /// that every status message counts towards the time between an
+  /// application's messages.
+  void recordMessage(const int aSimHandle, const int aMsgType);
+
+  /// Milliseconds until the next application is due to be polled,
+  /// 0 if one is overdue, or aDefault if nothing is scheduled.
+  int msecsUntilDue(const int aDefault);
+
+  /// Turn adaptation of the intervals on or off.
+  void setAutoAdjust(const bool aFlag);
+  /// Set every application's interval, and the interval that new
+  /// applications start with. Used as is when adaptation is off.
+  void setInterval(const int aInterval);
+  /// The shortest interval currently in use.
+  int getInterval() const;
+  /// Set the longest we aim to leave a message waiting once it is
+  /// due (milliseconds)
+  void setLatencyTarget(const int aLatencyTarget);
+  int getLatencyTarget() const;
+  /// Get the state of an application.
+  /// @return false if it isn't being scheduled
+  bool getStats(const int aSimHandle, AppStats &aStats) const;
+
+private:
+  struct AppState {
+    int     mInterval;       //milliseconds
+    int64_t mDue;
+    bool    mPaused;
+    bool    mSeenStatus;
+    float   mHitRatio;
+    /// When the last status message turned up, -1 if none yet
+    int64_t mLastArrival;
+    /// Smoothed time between status messages and its mean deviation
+    /// (milliseconds), negative if not known yet
+    float   mMeanGap;
+    float   mGapDeviation;
+    /// Which of the queue entries for the application is current
+    unsigned int mGeneration;
+  };
+
+  struct QueueEntry {
+    QueueEntry(const int64_t aDue, const int aSimHandle,
+	       const unsigned int aGeneration)
+      : mDue(aDue), mSimHandle(aSimHandle), mGeneration(aGeneration) {}
+    bool operator>(const QueueEntry &aOther) const {
+      return mDue > aOther.mDue;
+    }
+
+    int64_t      mDue;
+    int          mSimHandle;
+    unsigned int mGeneration;
+  };
+  typedef std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+			      std::greater<QueueEntry> > Queue;
+
+  void resetState(AppState &aState, const int aInterval);
+  /// Queue an application to be polled at aDue, replacing any entry
+  /// it already has
+  void schedule(const int aSimHandle, AppState &aState, const int64_t aDue);
+  /// Update the estimate of the time between status messages
+  void recordArrival(AppState &aState, const int64_t aNow);
+  /// Choose how long to wait before polling again
+  int nextInterval(const AppState &aState, const int64_t aNow) const;
+  /// Drop queue entries for applications that have gone away or
+  /// been rescheduled since the entry was pushed, even to the same
+  /// time.
+  void discardStale();
+
+  mutable QMutex               mMutex;
+  lunchbox::Clock              mClock;
+  std::map<int, AppState>      mApps;
+  /// Next-due times, earliest first
+  Queue                        mQueue;
+  /// Generation of the next queue entry; never reused, so entries
+  /// from before an application was removed and added again are stale
+  unsigned int                 mNextGeneration;
+  int                          mInterval;
+  int                          mLatencyTarget;
+  bool                         mAutoAdjust;
+};
+
+#endif // __POLLSCHEDULER_H__
@@ -0,0 +1,215 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file regexecutor.h
+ *  @brief Header file for the thread that makes all steering library
+ *  calls.
+ */
+
+#ifndef __REGEXECUTOR_H__
+#define __REGEXECUTOR_H__
+
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <QMutex>
+#include <QPointer>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <lunchbox/clock.h>
+
+#include "latencyhistogram.h"
+
+#define REG_STRINGIFY_(x) #x
+#define REG_STRINGIFY(x) REG_STRINGIFY_(x)
+/// Name a library call after the function called and the place it
+/// is called from, so that each call site gets its own timings
+#define REG_CALL_SITE(aName) \
+  aName " (" __FILE__ ":" REG_STRINGIFY(__LINE__) ")"
+
+struct ReGRequest;
+
+/// The steering library is not thread-safe, so every call into it is
+/// made by this one thread. Other threads hand it work - either
+/// waiting for the result with call() or carrying on and collecting
+/// it later through the Future returned by post() - instead of all
+/// contending on a single lock for the duration of every call. The
+/// GUI thread's long calls (attaching, fetching logs, sending control
+/// messages) use callFromGui(), which keeps the windows redrawing
+/// while they wait.
+///
+/// The queue depth and, for each named call (usually one per call
+/// site, see REG_CALL_SITE), histograms of the time spent waiting in
+/// the queue and running are recorded so that it is easy to see
+/// which library calls dominate and which ones hold up the GUI.
+/// @author Robert Haines
+class ReGExecutor : public QThread {
+public:
+  /// A piece of work for the executor, usually a library call bound
+  /// to its arguments with boost::bind. Returns a ReG status code.
+  typedef boost::function<int ()> Task;
+
+  /// The result of a task passed to post()
+  class Future {
+  public:
+    Future();
+    /// Whether the task has finished
+    bool isReady() const;
+    /// Wait for the task to finish.
+    /// @return The value returned by the task
+    int get() const;
+    /// Wait up to aMsecs milliseconds for the task to finish
+    /// @return Whether it has
+    bool wait(const int aMsecs) const;
+
+  private:
+    friend class ReGExecutor;
+    boost::shared_ptr<ReGRequest> mRequest;
+  };
+
+  /// Timings for all of the calls made under one name
+  struct CallStats {
+    CallStats() : mCount(0), mGuiCount(0), mTotalWaitMs(0.0),
+		  mMaxWaitMs(0.0), mTotalRunMs(0.0), mMaxRunMs(0.0) {}
+    unsigned long mCount;
+    /// How many of the calls were made by the GUI thread
+    unsigned long mGuiCount;
+    /// Time spent queued before running
+    double        mTotalWaitMs;
+    double        mMaxWaitMs;
+    /// Time spent running
+    double        mTotalRunMs;
+    double        mMaxRunMs;
+    /// The same times in microseconds
+    LatencyHistogram mWaitHist;
+    LatencyHistogram mRunHist;
+  };
+
+  ReGExecutor();
+  ~ReGExecutor();
+
+  /// Run aTask on the executor thread and wait for it to finish.
+  /// Tasks run straight away if called from the executor thread, or
+  /// once the executor has been stopped.
+  /// @param aName What to record the timings under
+  /// @return The value returned by aTask
+  int call(const char *aName, const Task &aTask);
+  /// Queue aTask to run on the executor thread and return at once.
+  /// @param aName What to record the timings under
+  Future post(const char *aName, const Task &aTask);
+  /// As call(), but if called from the GUI thread it handles the
+  /// GUI's events, other than user input, while it waits so that
+  /// the windows are still redrawn behind a slow call.
+  ///
+  /// Its callers (attaching, fetching the parameter logs and sending
+  /// control messages) are in the middle of working on an
+  /// Application's tables, so they must not be re-entered. Only
+  /// repaints and the timers that show what is already there (the
+  /// poll statistics and the history-only redraw) are handled
+  /// straight away; anything that could detach, save the history
+  /// cache or make another library call must be put off with
+  /// deferEvent().
+  int callFromGui(const char *aName, const Task &aTask);
+  /// For the GUI thread's event handlers. If callFromGui() is waiting
+  /// post an event of type aType to aReceiver again once it has
+  /// finished.
+  /// @return Whether the event was put off, in which case the caller
+  /// should ignore it for now
+  bool deferEvent(QObject *aReceiver, const int aType);
+
+  /// Run everything that's queued then stop the thread
+  void stop();
+
+  /// Number of tasks waiting to run
+  unsigned int getQueueDepth() const;
+  /// Largest number of tasks that have been waiting at once
+  unsigned int getMaxQueueDepth() const;
+  /// Timings for each name passed to call() or post()
+  std::map<std::string, CallStats> getStats() const;
+  /// The timings as a table, most expensive calls first
+  QString getStatsReport() const;
+
+protected:
+  virtual void run();
+
+private:
+  /// Run a request and record its timings
+  void execute(ReGRequest &aRequest);
+  /// Wait for a request to finish
+  int waitFor(ReGRequest &aRequest);
+  /// Wait up to aMsecs for a request to finish
+  /// @return Whether it has
+  bool waitFor(ReGRequest &aRequest, const int aMsecs);
+  /// Post the events put off by deferEvent()
+  void postDeferredEvents();
+
+  friend class Future;
+
+  mutable QMutex                   mMutex;
+  /// Signalled when there is work to do
+  QWaitCondition                   mWorkCondition;
+  /// Signalled when a request has finished
+  QWaitCondition                   mDoneCondition;
+  std::deque<boost::shared_ptr<ReGRequest> > mQueue;
+  bool                             mKeepRunning;
+  unsigned int                     mMaxQueueDepth;
+  std::map<std::string, CallStats> mStats;
+  lunchbox::Clock                  mClock;
+  /// How many callFromGui()s the GUI thread is waiting in
+  int                              mGuiCallDepth;
+  /// The receivers and types of the events put off until then. Only
+  /// used by the GUI thread.
+  std::vector<std::pair<QPointer<QObject>, int> > mDeferredEvents;
+};
+
+#endif // __REGEXECUTOR_H__
@@ -0,0 +1,98 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file seriescodec.h
+ *  @brief Header file for compressing blocks of a series of values.
+ */
+
+#ifndef __SERIESCODEC_H__
+#define __SERIESCODEC_H__
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+/// Compresses a block of a series of values so that long histories
+/// take up less memory. Which encoding is used is chosen per block:
+///
+/// - blocks of whole numbers (sequence numbers, REG_INT parameters)
+///   are stored as the difference between successive differences,
+///   which takes a single bit per value for anything that goes up by
+///   the same amount each time;
+/// - anything else (REG_FLOAT and REG_DBL parameters, gaps) is stored
+///   as the XOR of each value with the one before, leaving out the
+///   leading and trailing zero bits, since values that change slowly
+///   share most of their bits.
+///
+/// Blocks of 64-bit integers are always stored the first way, and
+/// blocks of floats the second. Both are lossless, so a decoded block
+/// is bit-for-bit what was encoded. A block is decoded in one go, so
+/// any value in a series is at most one block decode away.
+/// @author Robert Haines
+class SeriesCodec {
+public:
+  /// Compress aCount values
+  /// @param aOut Has the compressed block appended to it
+  static void encode(const double *aValues, const int aCount,
+		     std::vector<char> &aOut);
+  static void encode(const float *aValues, const int aCount,
+		     std::vector<char> &aOut);
+  static void encode(const int64_t *aValues, const int aCount,
+		     std::vector<char> &aOut);
+  /// Decompress a block made by encode() from values of the same type
+  /// @param aValues Has room for the aCount values that were encoded
+  /// @return false if the block is corrupt
+  static bool decode(const char *aData, const size_t aBytes,
+		     double *aValues, const int aCount);
+  static bool decode(const char *aData, const size_t aBytes,
+		     float *aValues, const int aCount);
+  static bool decode(const char *aData, const size_t aBytes,
+		     int64_t *aValues, const int aCount);
+};
+
+#endif // __SERIESCODEC_H__
@@ -0,0 +1,150 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file seriesstore.h
+ *  @brief Header file for the interface to a series of values.
+ */
+
+#ifndef __SERIESSTORE_H__
+#define __SERIESSTORE_H__
+
+#include <cstddef>
+#include <iterator>
+#include <stdint.h>
+#include <boost/shared_ptr.hpp>
+
+class HistorySpool;
+
+/// An append-only series of values, read as doubles whatever they
+/// are stored as. This is what the history plots and the data export
+/// read; the values themselves are held by a TypedSeries of the
+/// parameter's type, made by create(). Integers can also be added
+/// and read as 64-bit integers, so that they stay exact.
+///
+/// Values can be read by index or with a const_iterator.
+/// @author Robert Haines
+class SeriesStore {
+public:
+  /// Values are stored in segments of 2^kSEGMENT_BITS values
+  static const int kSEGMENT_BITS = 13;
+  static const int kSEGMENT_SIZE = 1 << kSEGMENT_BITS;
+
+  /// Iterates over the values in order
+  class const_iterator
+    : public std::iterator<std::forward_iterator_tag, double,
+			   std::ptrdiff_t, const double *, double> {
+  public:
+    const_iterator() : mStore(0), mIndex(0) {}
+    double operator*() const { return mStore->at(mIndex); }
+    const_iterator &operator++() { ++mIndex; return *this; }
+    const_iterator operator++(int) {
+      const_iterator lOld(*this);
+      ++mIndex;
+      return lOld;
+    }
+    bool operator==(const const_iterator &aOther) const {
+      return mIndex == aOther.mIndex && mStore == aOther.mStore;
+    }
+    bool operator!=(const const_iterator &aOther) const {
+      return !(*this == aOther);
+    }
+    /// The position of the value in the series
+    int index() const { return mIndex; }
+
+  private:
+    friend class SeriesStore;
+    const_iterator(const SeriesStore *aStore, const int aIndex)
+      : mStore(aStore), mIndex(aIndex) {}
+    const SeriesStore *mStore;
+    int                mIndex;
+  };
+
+  virtual ~SeriesStore();
+
+  /// Make an empty series to hold values of a REG_* type: 64-bit
+  /// integers for REG_INT, floats for REG_FLOAT and doubles for
+  /// anything else
+  static SeriesStore *create(const int aType);
+
+  /// Add a value to the end of the series. NaN means no value.
+  virtual void append(const double aValue) = 0;
+  /// Add an integer to the end of the series, exactly if it holds
+  /// integers. The most negative integer means no value.
+  virtual void appendInt64(const int64_t aValue) = 0;
+  /// Forget all of the values
+  virtual void clear() = 0;
+  /// Move all but the most recent values out to aSpool from now on
+  virtual void setSpool(const boost::shared_ptr<HistorySpool> &aSpool) = 0;
+  /// Free the values before aIndex, a whole segment at a time. They
+  /// must not be read after this.
+  virtual void release(const int aIndex) = 0;
+
+  /// Number of values stored
+  virtual int size() const = 0;
+  bool empty() const { return size() == 0; }
+  /// Index of the first value that hasn't been released
+  virtual int getFirstKept() const = 0;
+  /// The value at aIndex, which must be less than size()
+  virtual double at(const int aIndex) const = 0;
+  double operator[](const int aIndex) const { return at(aIndex); }
+  /// Whether the values are held as integers, so that atInt64() reads
+  /// them exactly
+  virtual bool holdsIntegers() const = 0;
+  /// The value at aIndex as an integer, rounded towards zero if it
+  /// isn't held as one. No value reads as the most negative integer.
+  virtual int64_t atInt64(const int aIndex) const = 0;
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+
+protected:
+  /// Report a compressed segment that couldn't be decoded
+  static void reportCorrupt(const int aSegment);
+};
+
+#endif // __SERIESSTORE_H__
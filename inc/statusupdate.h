@@ -0,0 +1,129 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file statusupdate.h
+ *  @brief Header file for the snapshots of application state passed
+ *  from the CommsThread to the GUI.
+ */
+
+#ifndef __STATUSUPDATE_H__
+#define __STATUSUPDATE_H__
+
+#include <vector>
+#include <QString>
+
+#include "paramvalue.h"
+
+/// The state of a parameter as held by the steering library
+/// @author Robert Haines
+struct ParamState {
+  int     mHandle;
+  int     mType;
+  QString mLabel;
+  /// The value, parsed once according to mType
+  ParamValue mParsed;
+  QString mMinVal;
+  QString mMaxVal;
+};
+
+/// The state of an IOType or ChkType as held by the steering library
+/// @author Robert Haines
+struct IOTypeState {
+  int     mHandle;
+  int     mType;
+  /// How often it is emitted/taken, in steps
+  int     mFrequency;
+  QString mLabel;
+};
+
+/// The parameter values carried by a single status message. Strings,
+/// and numbers that didn't parse, are left out as they aren't logged.
+/// @author Robert Haines
+struct StatusRecord {
+  /// The application's sequence number for this status
+  int                  mSeqNum;
+  /// Parameter handles, in step with mValues
+  std::vector<int>        mHandles;
+  /// The values as parsed, so that each keeps its own type and
+  /// integers stay exact
+  std::vector<ParamValue> mValues;
+};
+
+/// Everything the GUI needs from the messages that arrived for an
+/// application since it last looked, read from the steering library
+/// by the CommsThread so that the GUI never has to call it. While the
+/// GUI is busy new messages are merged in so that only the latest
+/// state is drawn, but the values from every status still reach the
+/// history.
+/// @author Robert Haines
+struct StatusUpdate {
+  StatusUpdate()
+    : mHaveParams(false), mHaveIOTypes(false), mHaveChkTypes(false),
+      mHistoryOnly(false) {}
+
+  /// Whether mMonParams and mSteerParams are filled in
+  bool                      mHaveParams;
+  std::vector<ParamState>   mMonParams;
+  std::vector<ParamState>   mSteerParams;
+  /// Whether mIOTypes is filled in
+  bool                      mHaveIOTypes;
+  std::vector<IOTypeState>  mIOTypes;
+  /// Whether mChkTypes is filled in
+  bool                      mHaveChkTypes;
+  std::vector<IOTypeState>  mChkTypes;
+  /// One record per status, oldest first
+  std::vector<StatusRecord> mRecords;
+  /// The commands from all of the statuses, in order
+  std::vector<int>          mCommands;
+  /// Set by the CommsThread when the GUI has fallen behind, in which
+  /// case the values should be logged but the tables needn't be
+  /// redrawn straight away
+  bool                      mHistoryOnly;
+};
+
+#endif // __STATUSUPDATE_H__
@@ -75,6 +75,13 @@ class SteererConfig {
   bool mAutoPollingOn;
   /** The default polling interval when not setting it automatically */
   float mPollingIntervalSecs;
+  /** The latency to aim for when setting the polling interval
+      automatically */
+  float mLatencyTargetSecs;
+  /** The most messages to handle in one go before sleeping */
+  int mDrainMaxMessages;
+  /** The longest to spend handling messages in one go before sleeping */
+  float mDrainMaxSecs;
   /** Whether or not to show the table of monitored parameters by default */
   bool mShowMonParamTable;
   /** Whether or not to show the table of steerable parameters by default */
@@ -83,6 +90,30 @@ class SteererConfig {
   bool mShowIOTypeTable;
   /** Whether or not to show the table of ChkTypes by default */
   bool mShowChkTypeTable;
+  /** How many status messages can be waiting to be shown before the
+      tables stop being redrawn for every one */
+  int mHistoryOnlyDepth;
+  /** Directory to spool parameter histories to (the system's
+      temporary directory if empty) */
+  QString mHistorySpoolDir;
+  /** How many of the latest values of each parameter to keep in
+      memory, or 0 to keep them all and not spool to file */
+  int mHistoryHotValues;
+  /** Whether to compress the values that aren't kept in memory as
+      they are */
+  bool mHistoryCompress;
+  /** How many of the latest values of each parameter to keep at
+      all, or 0 to keep them all. Older ones are only kept as coarse
+      summaries. */
+  int mHistoryRetainValues;
+  /** Directory to keep each application's parameter histories in
+      between attaches, if any */
+  QString mHistoryCacheDir;
+  /** File to write the timing statistics to on exit, if any */
+  QString mStatsDumpFile;
+  /** File to record a Chrome trace of the comms and GUI timeline
+      to, if any */
+  QString mTraceFile;
 
   SteererConfig();
   ~SteererConfig();
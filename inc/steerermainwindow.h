@@ -58,6 +58,7 @@
 #include <QEvent>
 #include <QLabel>
 #include <Q3PtrList>
+#include <lunchbox/clock.h>
 
 class Q3Action;
 class QLabel;
@@ -65,11 +66,15 @@ class QLayout;
 class QPixMap;
 class QPushButton;
 class QTabWidget;
+class QTimer;
 class QWidget;
 class QStackedWidget;
 
 #include "application.h"
 #include "steererconfig.h"
+#include "statusupdate.h"
+#include "regexecutor.h"
+#include "latencystats.h"
 
 class CommsThread;
 
@@ -91,9 +96,22 @@ public:
 
   /// Returns a pointer to the SteererConfig object
   SteererConfig *getConfig();
+  /// Cut short the CommsThread's current sleep, if it is running
+  void wakeCommsThread();
+  /// Returns a pointer to the thread that makes all steering
+  /// library calls
+  ReGExecutor *getExecutor();
+  /// Returns a pointer to the message latency statistics
+  LatencyStats *getLatencyStats();
+  /// Collect the status messages received for an application that
+  /// have not yet been processed
+  /// @return false if there are none
+  bool takeStatusUpdate(int aSimHandle, StatusUpdate &aUpdate);
 
 private:
   void cleanUp();
+  /// Write the library call timings and message latencies to a file
+  bool dumpStats(const QString &aFileName);
 
   bool isThreadRunning() const;
   void resizeForNoAttached();
@@ -112,6 +130,11 @@ protected slots:
   void hideIOTableSlot();
   void hideSteerTableSlot();
   void hideMonTableSlot();
+  void showCallStatsSlot();
+  void showLatencyStatsSlot();
+  void saveLatencyStatsSlot();
+  /// Show how the current application is being polled
+  void updatePollStatsSlot();
 
 public slots:
   void statusBarMessageSlot(Application *aApp, QString &message);
@@ -132,7 +155,11 @@ private:
   QPixmap	*mStackLogoPixMap;
 
   CommsThread	*mCommsThread;
-  QMutex         mReGMutex;
+  /// Makes all of the steering library calls. Declared before
+  /// mAppList so that it outlives the applications.
+  ReGExecutor    mExecutor;
+  /// How long messages take to get from the library to the tables
+  LatencyStats   mLatencyStats;
   Q3Action	*mSetCheckIntervalAction;
   Q3Action	*mToggleAutoPollAction;
   Q3Action	*mAttachAction;
@@ -143,6 +170,14 @@ private:
   Q3Action       *mHideIOTableAction;
   Q3Action       *mHideSteerTableAction;
   Q3Action       *mHideMonTableAction;
+  Q3Action       *mShowCallStatsAction;
+  Q3Action       *mShowLatencyStatsAction;
+  Q3Action       *mSaveLatencyStatsAction;
+
+  /// Shows the polling interval and hit ratio for the current
+  /// application, refreshed by mPollStatsTimer
+  QLabel        *mPollStatsLabel;
+  QTimer        *mPollStatsTimer;
 
   Q3PtrList<Application> mAppList;
   /// Holds the configuration information for the steering client
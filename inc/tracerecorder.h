@@ -0,0 +1,143 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file tracerecorder.h
+ *  @brief Header file for recording a timeline of what the steerer's
+ *  threads are doing as Chrome trace events.
+ */
+
+#ifndef __TRACERECORDER_H__
+#define __TRACERECORDER_H__
+
+#include <QString>
+#include <stdint.h>
+
+/// Records a timeline of what the steerer's threads are doing and
+/// writes it as Chrome trace-event JSON, which can be loaded into
+/// chrome://tracing or Perfetto to see how the CommsThread's polls,
+/// the library calls, the delivery of messages to the GUI and the
+/// redrawing of tables and plots line up.
+///
+/// Recording is off unless enable() has been called, in which case
+/// each thread appends complete events to a buffer of its own. A lock
+/// is only taken for a thread's first event, to create its buffer,
+/// and its first chunk of events; after that it appends without any.
+/// The buffers are kept until shutdown(). The names and categories
+/// of events are
+/// not copied so must be string literals (REG_CALL_SITE names are
+/// fine). Each thread keeps at most kTRACE_MAX_EVENTS events; any
+/// more are counted and dropped.
+/// @author Robert Haines
+class TraceRecorder {
+public:
+  /// Start recording. The trace is written to aFileName by write().
+  static void enable(const QString &aFileName);
+  /// Whether events are being recorded
+  static bool isEnabled() { return sEnabled; }
+
+  /// Name the calling thread in the trace. Can be called before
+  /// recording is enabled.
+  static void setThreadName(const char *aName);
+
+  /// The time to use for events, in microseconds
+  static int64_t now();
+  /// Record an event for the calling thread
+  /// @param aCategory The category of the event
+  /// @param aName The name of the event
+  /// @param aSimHandle The application it concerns, or -1 for none
+  /// @param aStart When it started (from now())
+  /// @param aEnd When it finished (from now())
+  static void record(const char *aCategory, const char *aName,
+		     const int aSimHandle, const int64_t aStart,
+		     const int64_t aEnd);
+
+  /// Write everything recorded so far to the file given to
+  /// enable(). Other threads can carry on recording while this runs
+  /// but what they add may be missed.
+  /// @return false if recording is off or the file couldn't be
+  /// written
+  static bool write();
+  /// Stop recording and free everything that has been recorded. Only
+  /// call this once the other threads that record have finished, as
+  /// at exit.
+  static void shutdown();
+
+private:
+  static volatile bool sEnabled;
+};
+
+/// Records an event covering its own lifetime, or up to finish()
+/// being called, if recording is on when it is created.
+/// @author Robert Haines
+class TraceScope {
+public:
+  TraceScope(const char *aCategory, const char *aName,
+	     const int aSimHandle = -1)
+    : mCategory(aCategory), mName(aName), mSimHandle(aSimHandle),
+      mStart(TraceRecorder::isEnabled() ? TraceRecorder::now() : -1) {}
+  ~TraceScope() { finish(); }
+
+  /// Set which application the event concerns, if it wasn't known
+  /// when it started
+  void setSimHandle(const int aSimHandle) { mSimHandle = aSimHandle; }
+  /// End the event now rather than when this goes out of scope
+  void finish() {
+    if(mStart >= 0)
+      TraceRecorder::record(mCategory, mName, mSimHandle, mStart,
+			    TraceRecorder::now());
+    mStart = -1;
+  }
+
+private:
+  const char *mCategory;
+  const char *mName;
+  int         mSimHandle;
+  int64_t     mStart;
+};
+
+#endif // __TRACERECORDER_H__
@@ -0,0 +1,352 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file typedseries.h
+ *  @brief Header file for segmented storage of a series of values of
+ *  one type.
+ */
+
+#ifndef __TYPEDSERIES_H__
+#define __TYPEDSERIES_H__
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <stdint.h>
+
+#include "seriesstore.h"
+#include "seriescodec.h"
+#include "historyspool.h"
+
+/// How a TypedSeries converts its values to and from doubles and
+/// integers
+template <typename T>
+struct SeriesTraits;
+
+/// Integers can't be NaN, so the most negative one stands in for it
+template <>
+struct SeriesTraits<int64_t> {
+  static bool isInteger() { return true; }
+  static int64_t noValue() { return (int64_t) ((uint64_t) 1 << 63); }
+  static int64_t fromDouble(const double aValue) {
+    if(!(aValue > -9.2e18 && aValue < 9.2e18))
+      return noValue();
+    return (int64_t) aValue;
+  }
+  static double toDouble(const int64_t aValue) {
+    return aValue == noValue() ?
+      std::numeric_limits<double>::quiet_NaN() : (double) aValue;
+  }
+  static int64_t fromInt64(const int64_t aValue) { return aValue; }
+  static int64_t toInt64(const int64_t aValue) { return aValue; }
+};
+
+template <typename T>
+struct SeriesTraits {
+  static bool isInteger() { return false; }
+  static T fromDouble(const double aValue) { return (T) aValue; }
+  static double toDouble(const T aValue) { return aValue; }
+  static T fromInt64(const int64_t aValue) {
+    return aValue == SeriesTraits<int64_t>::noValue() ?
+      std::numeric_limits<T>::quiet_NaN() : (T) aValue;
+  }
+  static int64_t toInt64(const T aValue) {
+    return SeriesTraits<int64_t>::fromDouble(aValue);
+  }
+};
+
+/// A SeriesStore holding its values as T (int64_t, float or double)
+/// in fixed-size segments, so that appending never has to copy what
+/// is already there and the address of a value never changes once it
+/// has been stored. This means something like a plot can keep
+/// looking at the values while more are added.
+///
+/// If given a HistorySpool, only its hot window of the most recent
+/// segments is kept in memory as they are. Older ones are moved out
+/// to its file and/or compressed with SeriesCodec, if it is
+/// compressing. A value's address changes when it is moved out, so
+/// anything holding on to values for longer than that should read
+/// them through valueAt() or at().
+///
+/// As well as one at a time, values can be read a span (a run of
+/// values that are next to each other in memory) at a time. Reading
+/// a value from a compressed segment decodes the whole segment, which
+/// is kept until a value from another compressed segment is read, so
+/// reading in order is cheap.
+/// @author Robert Haines
+template <typename T>
+class TypedSeries : public SeriesStore {
+public:
+  typedef SeriesTraits<T> Traits;
+
+  /// Values that are next to each other in memory. If they are from
+  /// a compressed segment they are only there until a value from
+  /// another one is read.
+  struct Span {
+    Span(const T *aData, const int aSize) : mData(aData), mSize(aSize) {}
+    const T *mData;
+    int      mSize;
+  };
+
+  TypedSeries()
+    : mSize(0), mFirstHot(0), mFirstKept(0), mUnpackedSegment(-1) {}
+  virtual ~TypedSeries() { clear(); }
+
+  /// Add a value to the end of the series
+  void appendValue(const T aValue) {
+    if((mSize >> kSEGMENT_BITS) == (int) mSegments.size())
+      addSegment();
+    mSegments[mSize >> kSEGMENT_BITS][mSize & (kSEGMENT_SIZE - 1)] = aValue;
+    mSize++;
+  }
+  /// The value at aIndex, which must be less than size()
+  T valueAt(const int aIndex) const {
+    const T *lSegment = mSegments[aIndex >> kSEGMENT_BITS];
+    if(!lSegment)
+      lSegment = unpack(aIndex >> kSEGMENT_BITS);
+    return lSegment[aIndex & (kSEGMENT_SIZE - 1)];
+  }
+
+  virtual void append(const double aValue) {
+    appendValue(Traits::fromDouble(aValue));
+  }
+  virtual void appendInt64(const int64_t aValue) {
+    appendValue(Traits::fromInt64(aValue));
+  }
+  virtual void clear();
+  virtual void setSpool(const boost::shared_ptr<HistorySpool> &aSpool) {
+    mSpool = aSpool;
+  }
+  virtual void release(const int aIndex);
+
+  virtual int size() const { return mSize; }
+  virtual int getFirstKept() const { return mFirstKept << kSEGMENT_BITS; }
+  virtual double at(const int aIndex) const {
+    return Traits::toDouble(valueAt(aIndex));
+  }
+  virtual bool holdsIntegers() const { return Traits::isInteger(); }
+  virtual int64_t atInt64(const int aIndex) const {
+    return Traits::toInt64(valueAt(aIndex));
+  }
+
+  /// Number of spans the values are split into
+  int getNumSpans() const {
+    return (mSize + kSEGMENT_SIZE - 1) >> kSEGMENT_BITS;
+  }
+  /// One of the spans, in order
+  Span getSpan(const int aSpan) const;
+
+private:
+  // not copyable - the segments are owned
+  TypedSeries(const TypedSeries &);
+  TypedSeries &operator=(const TypedSeries &);
+
+  /// A segment that has been compressed
+  struct Packed {
+    Packed(const char *aData, const size_t aBytes, const bool aOwned)
+      : mData(aData), mBytes(aBytes), mOwned(aOwned) {}
+    const char *mData;
+    size_t      mBytes;
+    /// Whether mData is ours rather than in the spool's file
+    bool        mOwned;
+  };
+
+  void addSegment();
+  /// Move the oldest hot segment out of memory and/or compress it
+  bool moveOut();
+  /// Decode a compressed segment
+  const T *unpack(const int aSegment) const;
+
+  /// Each is kSEGMENT_SIZE values long, or NULL if compressed
+  std::vector<T *>    mSegments;
+  int                 mSize;
+  /// Where old segments are moved out to, if anywhere
+  boost::shared_ptr<HistorySpool> mSpool;
+  /// The segments before this are in mSpool's file or compressed
+  /// rather than owned
+  int                 mFirstHot;
+  /// The compressed form of each of the segments before mFirstHot
+  /// (with no data if it was moved out as it was, or released)
+  std::vector<Packed> mPacked;
+  /// The segments before this have been released
+  int                 mFirstKept;
+  /// The compressed segment that was decoded last
+  mutable int            mUnpackedSegment;
+  mutable std::vector<T> mUnpacked;
+};
+
+template <typename T>
+void
+TypedSeries<T>::clear()
+{
+  // spooled segments belong to the spool
+  for(unsigned int i = mFirstHot; i < mSegments.size(); i++)
+    delete [] mSegments[i];
+  for(unsigned int i = 0; i < mPacked.size(); i++)
+    if(mPacked[i].mOwned)
+      delete [] mPacked[i].mData;
+  mSegments.clear();
+  mPacked.clear();
+  mSize = 0;
+  mFirstHot = 0;
+  mFirstKept = 0;
+  mUnpackedSegment = -1;
+}
+
+template <typename T>
+void
+TypedSeries<T>::release(const int aIndex)
+{
+  // never the segment being added to
+  int lEnd = aIndex >> kSEGMENT_BITS;
+  if(lEnd > (int) mSegments.size() - 1)
+    lEnd = mSegments.size() - 1;
+
+  for(; mFirstKept < lEnd; mFirstKept++){
+    if(mFirstKept >= mFirstHot){
+      // still in memory as it was, so it counts as moved out now
+      delete [] mSegments[mFirstKept];
+      mPacked.push_back(Packed(NULL, 0, false));
+      mFirstHot = mFirstKept + 1;
+    }
+    else if(mPacked[mFirstKept].mOwned)
+      delete [] mPacked[mFirstKept].mData;
+
+    // anything in the spool's file stays there until it is closed
+    mSegments[mFirstKept] = NULL;
+    mPacked[mFirstKept] = Packed(NULL, 0, false);
+    if(mUnpackedSegment == mFirstKept)
+      mUnpackedSegment = -1;
+  }
+}
+
+template <typename T>
+typename TypedSeries<T>::Span
+TypedSeries<T>::getSpan(const int aSpan) const
+{
+  const int lStart = aSpan << kSEGMENT_BITS;
+  const int lSize = mSize - lStart < kSEGMENT_SIZE ?
+    mSize - lStart : kSEGMENT_SIZE;
+  const T *lSegment = mSegments[aSpan];
+
+  return Span(lSegment ? lSegment : unpack(aSpan), lSize);
+}
+
+template <typename T>
+void
+TypedSeries<T>::addSegment()
+{
+  mSegments.push_back(new T[kSEGMENT_SIZE]);
+
+  if(!mSpool || (!mSpool->isOpen() && !mSpool->isCompressing()))
+    return;
+
+  // Move the oldest full segments out until only the hot window is
+  // left. If the spool can't take them just keep them.
+  while((int) mSegments.size() - mFirstHot > mSpool->getHotSegments()){
+    if(!moveOut())
+      break;
+    mFirstHot++;
+  }
+}
+
+template <typename T>
+bool
+TypedSeries<T>::moveOut()
+{
+  T *lSegment = mSegments[mFirstHot];
+
+  if(!mSpool->isCompressing()){
+    const char *lSpooled = mSpool->write((const char *) lSegment,
+					 kSEGMENT_SIZE * sizeof(T));
+    if(!lSpooled)
+      return false;
+    mPacked.push_back(Packed(NULL, 0, false));
+    mSegments[mFirstHot] = (T *) lSpooled;
+  }
+  else{
+    std::vector<char> lBlock;
+    SeriesCodec::encode(lSegment, kSEGMENT_SIZE, lBlock);
+
+    // keep it ourselves if it can't go in the file
+    const char *lSpooled = mSpool->isOpen() ?
+      mSpool->write(&lBlock[0], lBlock.size()) : NULL;
+    if(lSpooled)
+      mPacked.push_back(Packed(lSpooled, lBlock.size(), false));
+    else{
+      char *lCopy = new char[lBlock.size()];
+      std::copy(lBlock.begin(), lBlock.end(), lCopy);
+      mPacked.push_back(Packed(lCopy, lBlock.size(), true));
+    }
+    mSegments[mFirstHot] = NULL;
+  }
+
+  delete [] lSegment;
+  return true;
+}
+
+template <typename T>
+const T *
+TypedSeries<T>::unpack(const int aSegment) const
+{
+  if(aSegment != mUnpackedSegment){
+    mUnpacked.resize(kSEGMENT_SIZE);
+    const Packed &lPacked = mPacked[aSegment];
+    if(!SeriesCodec::decode(lPacked.mData, lPacked.mBytes, &mUnpacked[0],
+			    kSEGMENT_SIZE)){
+      reportCorrupt(aSegment);
+      std::fill(mUnpacked.begin(), mUnpacked.end(),
+		Traits::fromDouble(std::numeric_limits<double>::quiet_NaN()));
+    }
+    mUnpackedSegment = aSegment;
+  }
+
+  return &mUnpacked[0];
+}
+
+#endif // __TYPEDSERIES_H__
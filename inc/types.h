@@ -101,10 +101,44 @@
 #define kMIN_POLLING_INT	1
 #define kMAX_POLLING_INT        2000
 
+/// default latency target for automatic polling (milliseconds)
+#define kLATENCY_TARGET         100
+
+/// default limits on how many messages (and how many milliseconds)
+/// the commsthread handles in one go before sleeping again
+#define kDRAIN_MAX_MSGS         64
+#define kDRAIN_MAX_TIME         100
+
+/// default number of status messages that can be waiting for the GUI
+/// before an application's tables are only redrawn now and again
+/// (history-only mode), the multiple of that at which the commsthread
+/// stops polling the application until the GUI has caught up, and
+/// how often the tables are redrawn
+/// in history-only mode (milliseconds)
+#define kHISTORY_ONLY_DEPTH     32
+#define kMAX_PENDING_FACTOR     8
+#define kHISTORY_ONLY_REDRAW    500
+
+/// Number of messages each Application can have waiting for the
+/// GUI thread before the commsthread has to wait for it
+#define kMSG_QUEUE_SIZE         256
+
+/// How many of the most recent values of each parameter's history
+/// to keep in memory once the rest is spooled to file
+#define kHISTORY_HOT_VALUES     65536
+
+/// How many buckets each of the finer tiers of a parameter's history
+/// keeps once old values are being dropped
+#define kHISTORY_TIER_BUCKETS   4096
+
+/// Most events each thread keeps when recording a trace
+#define kTRACE_MAX_EVENTS       (1 << 20)
+
 /// Unique numbers to make QCustomEvent IDs for postEvent
-/// from CommsThread.cpp
+/// from CommsThread.cpp and HistoryCacheLoader
 #define kMSG_EVENT		100
 #define kSIGNAL_EVENT		200
+#define kHISTORY_CACHE_EVENT	300
 
 /// Maximum number of plots in a single history plot
 #define kMAX_HISTORY_PLOTS      10
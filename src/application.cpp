@@ -65,24 +65,40 @@
 //Added by qt3to4:
 #include <Q3HBoxLayout>
 #include <QEvent>
+#include <QCoreApplication>
+#include <QDir>
 
 #include "buildconfig.h"
 #include "types.h"
 #include "application.h"
 #include "controlform.h"
+#include "parametertable.h"
 #include "debug.h"
 #include "commsthread.h"
 #include "exception.h"
 #include "steerermainwindow.h"
+#include "regexecutor.h"
+#include "historycache.h"
+#include "historyspool.h"
+#include "steererconfig.h"
+#include "tracerecorder.h"
+
+#include <boost/bind.hpp>
 
 #include "ReG_Steer_Steerside.h"
 
 Application::Application(QWidget *aParent, const char *aName,
-			 int aSimHandle, bool aIsLocal, QMutex *aMutex)
-  : QWidget(aParent, aName), mSimHandle(aSimHandle), mMutexPtr(aMutex),
+			 int aSimHandle, bool aIsLocal, ReGExecutor *aExecutor,
+			 const QString &aHistoryKey)
+  : QWidget(aParent, aName), mSimHandle(aSimHandle), mExecutor(aExecutor),
     mNumCommands(0), mDetachSupported(false), mStopSupported(false),
     mPauseSupported(false),  mResumeSupported(false), mDetachedFlag(false),
-    mStatusTxt(""), mControlForm(kNULL), mControlBox(kNULL)
+    mStatusTxt(""), mControlForm(kNULL), mControlBox(kNULL),
+    mHistoryCacheLoader(kNULL), mHistoryLogFetched(false),
+    mHistorySaved(false),
+    mMessages(kMSG_QUEUE_SIZE), mWakeupPending(0),
+    mAttachMs(-1.0f), mReadyMs(-1.0f), mFirstMessageMs(-1.0f),
+    mFirstPaintMs(-1.0f), mAwaitingFirstPaint(false), mHistoryOnly(false)
 {
 
   // MR keep an internal record of whether we're local or grid
@@ -99,7 +115,7 @@ Application::Application(QWidget *aParent, const char *aName,
   // (parameters etc)
   mControlBox = new Q3GroupBox(1, Qt::Vertical, "", this, "editbox" );
   mControlForm = new ControlForm(mControlBox, aName, aSimHandle, this,
-				 mMutexPtr);
+				 mExecutor);
   lFormLayout->addWidget(mControlBox);
   //this->addChild(mControlBox);
 
@@ -112,6 +128,33 @@ Application::Application(QWidget *aParent, const char *aName,
   // status bar text as and when necessary
   mSteerer = (SteererMainWindow*)aParent;
 
+  // Keep only the latest values of the parameter histories in memory
+  // if asked to
+  SteererConfig *lConfig = mSteerer->getConfig();
+  if(lConfig->mHistoryHotValues > 0){
+    QString lDir = lConfig->mHistorySpoolDir.isEmpty() ?
+      QDir::tempPath() : lConfig->mHistorySpoolDir;
+    mHistorySpool.reset(new HistorySpool(lDir, mSimHandle,
+					 lConfig->mHistoryHotValues,
+					 lConfig->mHistoryCompress));
+    if(!mHistorySpool->isOpen() && !mHistorySpool->isCompressing())
+      mHistorySpool.reset();
+  }
+  mHistoryTable.setSpool(mHistorySpool);
+  mHistoryTable.setRetainedRows(lConfig->mHistoryRetainValues);
+
+  // Show the histories from the last time we were attached to this
+  // application as soon as they have been read in, which is done in
+  // the background as there could be a lot of them
+  if(!lConfig->mHistoryCacheDir.isEmpty()){
+    mHistoryCache.reset(new HistoryCache(lConfig->mHistoryCacheDir,
+					 aHistoryKey));
+    mHistoryCacheLoader =
+      new HistoryCacheLoader(mHistoryCache.get(), this,
+			     QEvent::User + kHISTORY_CACHE_EVENT);
+    mHistoryCacheLoader->start();
+  }
+
   // MR
   // This message was originally automatically added to the
   // old style status text on app creation. Do it  here instead
@@ -127,9 +170,14 @@ Application::Application(QWidget *aParent, const char *aName,
 Application::~Application()
 {
   REG_DBGDST("Application");
+  // save the histories unless that was done when the application
+  // detached
+  saveHistoryCache();
+
   // send detach to application if still attached
-  if (!mDetachedFlag)
+  if (!mDetachedFlag){
     detachFromApplication();
+  }
 
   delete mControlForm;  //check this SMR XXX
   mControlForm = kNULL;
@@ -144,9 +192,8 @@ void Application::detachFromApplication()
   REG_DBGMSG("Do Sim_detach");
   int lReGStatus = REG_FAILURE;
 
-  mMutexPtr->lock();
-  lReGStatus = Sim_detach(&lSimHandle);		// ReG library
-  mMutexPtr->unlock();
+  lReGStatus = mExecutor->call(REG_CALL_SITE("Sim_detach"),		// ReG library
+				boost::bind(Sim_detach, &lSimHandle));
 
   // note Sim_Detach always returns REG_SUCCESS surrrently!
   if (lReGStatus != REG_SUCCESS) {
@@ -155,6 +202,10 @@ void Application::detachFromApplication()
 
   // flag as detached so destructor knows not to detach
   mDetachedFlag = true;
+
+  // have the commsthread pick up the application's response now
+  // rather than at the end of its current sleep
+  mSteerer->wakeCommsThread();
 }
 
 void
@@ -172,6 +223,7 @@ Application::disableForDetach(const bool aUnRegister)
 void
 Application::disableForDetachOnError()
 {
+  saveHistoryCache();
   mControlForm->disableAll(true);
   mControlForm->setEnabledClose(true);
 }
@@ -192,9 +244,9 @@ Application::enableCmdButtons()
 
   try
   {
-    mMutexPtr->lock();
-    lReGStatus = Get_supp_cmd_number(mSimHandle, &mNumCommands);  //ReG library
-    mMutexPtr->unlock();
+    lReGStatus = mExecutor->call(REG_CALL_SITE("Get_supp_cmd_number"),  //ReG library
+				 boost::bind(Get_supp_cmd_number, mSimHandle,
+					     &mNumCommands));
 
     if (lReGStatus == REG_SUCCESS)
     {
@@ -202,9 +254,9 @@ Application::enableCmdButtons()
       {
 	lCmdIds = new int[mNumCommands];
 
-	mMutexPtr->lock();
-	lReGStatus = Get_supp_cmds(mSimHandle, mNumCommands, lCmdIds);	//ReG library
-	mMutexPtr->unlock();
+	lReGStatus = mExecutor->call(REG_CALL_SITE("Get_supp_cmds"),	//ReG library
+				     boost::bind(Get_supp_cmds, mSimHandle,
+						 mNumCommands, lCmdIds));
 
 	if (lReGStatus != REG_SUCCESS)
 	  THROWEXCEPTION("Get_supp_cmds");
@@ -381,23 +433,26 @@ Application::emitSingleCmd(int aCmdId)
 
   try
   {
-    mMutexPtr->lock();
     switch(aCmdId){
 
     case REG_STR_STOP:
-      lReGStatus = Emit_stop_cmd(mSimHandle);		//ReG library
+      lReGStatus = mExecutor->call(REG_CALL_SITE("Emit_stop_cmd"),		//ReG library
+				   boost::bind(Emit_stop_cmd, mSimHandle));
       break;
 
     case REG_STR_PAUSE:
-      lReGStatus = Emit_pause_cmd(mSimHandle);		//ReG library
+      lReGStatus = mExecutor->call(REG_CALL_SITE("Emit_pause_cmd"),	//ReG library
+				   boost::bind(Emit_pause_cmd, mSimHandle));
       break;
 
     case REG_STR_RESUME:
-      lReGStatus = Emit_resume_cmd(mSimHandle);		//ReG library
+      lReGStatus = mExecutor->call(REG_CALL_SITE("Emit_resume_cmd"),	//ReG library
+				   boost::bind(Emit_resume_cmd, mSimHandle));
       break;
 
     case REG_STR_DETACH:
-      lReGStatus = Emit_detach_cmd(mSimHandle);		//ReG library
+      lReGStatus = mExecutor->call(REG_CALL_SITE("Emit_detach_cmd"),	//ReG library
+				   boost::bind(Emit_detach_cmd, mSimHandle));
       break;
 
     default:
@@ -405,8 +460,6 @@ Application::emitSingleCmd(int aCmdId)
 
     }
 
-    mMutexPtr->unlock();
-
     if (lReGStatus != REG_SUCCESS)
       THROWEXCEPTION("Emit control");
   }
@@ -437,97 +490,164 @@ Application::customEvent(QEvent *aEvent)
   // - alternative is to have CommsThread execute processNextMessage
   // but then we need to worry about locking within Qt GUI related methods
 
+  // A library call made by the GUI thread may be waiting part way
+  // through the tables these would change, so leave them until it has
+  // finished. The wakeup flag stays set until then.
+  if (mExecutor->deferEvent(this, aEvent->type()))
+    return;
+
   // only expect events with type (User+kMSG_EVENT)
   if (aEvent->type() == QEvent::User+kMSG_EVENT)
   {
-    CommsThreadEvent *lEvent = (CommsThreadEvent *) aEvent;
-    processNextMessage(lEvent);
+    // clear the flag before emptying the queue so that anything
+    // queued from now on posts another event
+    mWakeupPending.fetchAndStoreOrdered(0);
+
+    TraceScope lTrace("gui", "deliver", mSimHandle);
+    LatencyStats *lStats = mSteerer->getLatencyStats();
+    QueuedMessage lMsg;
+    while(mMessages.pop(lMsg)){
+      lMsg.mStamps.mDispatched = lStats->now();
+      TraceScope lMsgTrace("gui", "processNextMessage", mSimHandle);
+      processNextMessage(lMsg.mMsgType);
+      lMsgTrace.finish();
+      lMsg.mStamps.mShown = lStats->now();
+      lStats->record(mSimHandle, lMsg.mMsgType, lMsg.mStamps);
+    }
   }
   else
   {
-    REG_DBGMSG("Application::customEvent -  unexpected event type");
+    // the cache has been read in
+    if (aEvent->type() == QEvent::User+kHISTORY_CACHE_EVENT)
+      finishLoadingHistoryCache();
+    else
+      REG_DBGMSG("Application::customEvent -  unexpected event type");
   }
 }
 
+//------------------------------------------------------------------------
+bool
+Application::postMessage(const int aMsgType,
+			 const LatencyStats::Stamps &aStamps)
+{
+  QueuedMessage lMsg;
+  lMsg.mMsgType = aMsgType;
+  lMsg.mStamps = aStamps;
+
+  if(!mMessages.push(lMsg))
+    return false;
+
+  // only wake the GUI thread if it hasn't already been woken
+  if(mWakeupPending.testAndSetOrdered(0, 1))
+    QCoreApplication::postEvent(this, new QEvent((QEvent::Type)
+						 (QEvent::User + kMSG_EVENT)));
+
+  return true;
+}
+
+//------------------------------------------------------------------------
+void
+Application::startTiming(const float aAttachMs, const float aReadyMs)
+{
+  mAttachMs = aAttachMs;
+  mReadyMs = aReadyMs;
+  mFirstMessageMs = -1.0f;
+  mFirstPaintMs = -1.0f;
+  mStartupClock.reset();
+
+  mControlForm->getMonParamTable()->viewport()->installEventFilter(this);
+}
+
+//------------------------------------------------------------------------
+bool
+Application::eventFilter(QObject *aObject, QEvent *aEvent)
+{
+  if(mAwaitingFirstPaint && aEvent->type() == QEvent::Paint){
+    mAwaitingFirstPaint = false;
+    mFirstPaintMs = mReadyMs + mStartupClock.getTimef();
+    aObject->removeEventFilter(this);
+
+    REG_DBGLOG1("Startup: attach call (ms) =", mAttachMs);
+    REG_DBGLOG1("Startup: form ready (ms) =", mReadyMs);
+    REG_DBGLOG1("Startup: first message (ms) =", mFirstMessageMs);
+    REG_DBGLOG1("Startup: first table paint (ms) =", mFirstPaintMs);
+  }
+
+  return QWidget::eventFilter(aObject, aEvent);
+}
+
 //------------------------------------------------------------------------
 void
-Application::processNextMessage(CommsThreadEvent *aEvent)
+Application::processNextMessage(const int aMsgType)
 {
-  int aMsgType = aEvent->getMsgType();
   // the commsthread has found a msg for this application - this
   // function calls ReG library routines to process that msg.
   // As thread uses postEvent, this func is executed by GUI thread
 
   // need this as this done in GUI loop cos of thread->postEvent is
-  // possible that this event posted before sim_detach happened for
-  // previous event if this is the case the file will have now been
+  // possible that this message queued before sim_detach happened for
+  // previous message if this is the case the file will have now been
   // deleted
   if (mDetachedFlag)
     return;
 
+  if(mFirstMessageMs < 0.0f && mReadyMs >= 0.0f)
+    mFirstMessageMs = mReadyMs + mStartupClock.getTimef();
+
   try
   {
     REG_DBGMSG1("Application::processNextMessage, msg type = ", aMsgType);
     switch(aMsgType){
 
     case IO_DEFS:
-
-      REG_DBGMSG("Application::processNextMessage Got IOdefs message");
-      // update IOType list and table
-      mControlForm->updateIOTypes(false);
-      break;
-
     case CHK_DEFS:
-
-      REG_DBGMSG("Application::processNextMessage Got Chkdefs message");
-      // update IOType list and table
-      mControlForm->updateIOTypes(true);
-      break;
-
     case PARAM_DEFS:
-
-      REG_DBGMSG("Application::processNextMessage Got param defs message");
-      // update parameter list and table
-      mControlForm->updateParameters(false);
-
-      break;
-
     case STATUS:
-
-      REG_DBGMSG("Application::processNextMessage Got status message");
-      int  num_cmds;
-      int  *commands;
+      {
+      REG_DBGMSG("Application::processNextMessage Got defs or status message");
       bool detached;
       detached = false;
-      // update parameter list and table
-      mControlForm->updateParameters(true);
 
-      // update IOType list and table (needed for frequency update)
-      mControlForm->updateIOTypes(false);	// sample types
-      mControlForm->updateIOTypes(true);	// checkpoint types
+      // pick up everything that has arrived since this message was
+      // queued - it may already have been picked up by an earlier one
+      StatusUpdate lUpdate;
+      if(!mSteerer->takeStatusUpdate(mSimHandle, lUpdate))
+	break;
+
+      // let the user know if we can't keep up with the application
+      if(lUpdate.mHistoryOnly != mHistoryOnly){
+	mHistoryOnly = lUpdate.mHistoryOnly;
+	QString message = mHistoryOnly ?
+	  QString("Falling behind application - tables updated less often") :
+	  QString("Caught up with application");
+	mSteerer->statusBarMessageSlot(this, message);
+      }
 
-      num_cmds = aEvent->getNumCmds();
-      if(num_cmds)commands = aEvent->getCmdsPtr();
+      // update parameter, IOType and ChkType lists and tables
+      mControlForm->applyUpdate(lUpdate);
+      // note when the table gets painted with its first parameters
+      if(lUpdate.mHaveParams && mReadyMs >= 0.0f && mFirstPaintMs < 0.0f)
+	mAwaitingFirstPaint = true;
 
       // now deal with commands
-      for(int i=0; i<num_cmds && !detached; i++){
+      for(unsigned int i=0; i<lUpdate.mCommands.size() && !detached; i++){
 
-	REG_DBGMSG2("Recd Cmd", i, commands[i]);
+	REG_DBGMSG2("Recd Cmd", i, lUpdate.mCommands[i]);
 	int lSimHandle = mSimHandle;
 
-	switch(commands[i]){
+	switch(lUpdate.mCommands[i]){
 
 	case REG_STR_DETACH:
 	  {
 	  REG_DBGMSG("Application::processNextMessage Received "
 		 "detach command from application");
 	  detached = true;
-	  mMutexPtr->lock();
-	  Delete_sim_table_entry(&lSimHandle);     //ReG library
-	  mMutexPtr->unlock();
+	  mExecutor->call(REG_CALL_SITE("Delete_sim_table_entry"),     //ReG library
+			  boost::bind(Delete_sim_table_entry, &lSimHandle));
 
 	  // make GUI form for this application read only
 	  disableForDetach(true);
+	  saveHistoryCache();
 	  QString message = QString("Application has detached");
 	  mSteerer->statusBarMessageSlot(this, message);
 
@@ -543,12 +663,12 @@ Application::processNextMessage(CommsThreadEvent *aEvent)
 	  REG_DBGMSG("Application::processNextMessage Received stop "
 		 "command from application");
 	  detached = true;
-	  mMutexPtr->lock();
-	  Delete_sim_table_entry(&lSimHandle);		//ReG library
-	  mMutexPtr->unlock();
+	  mExecutor->call(REG_CALL_SITE("Delete_sim_table_entry"),	//ReG library
+			  boost::bind(Delete_sim_table_entry, &lSimHandle));
 
 	  // make GUI form for this application read only
 	  disableForDetach(true);
+	  saveHistoryCache();
 	  QString message = QString("Detached as application has stopped");
 	  mSteerer->statusBarMessageSlot(this, message);
 
@@ -565,10 +685,16 @@ Application::processNextMessage(CommsThreadEvent *aEvent)
       } // end for
 
       break;
+      }
 
     case STEER_LOG:
       REG_DBGMSG("Application::processNextMessage Got steer_log message");
       mControlForm->updateParameterLog();
+
+      // the log has the histories of any parameters still in the cache
+      mHistoryLogFetched = true;
+      if(mHistoryCache && !mHistoryCacheLoader)
+	mHistoryCache->clear();
       break;
 
     case MSG_NOTSET:
@@ -723,9 +849,9 @@ void Application::emitGridRestartCmdSlot(){
   if(!ok || text.isEmpty())return;
 
   // Now issue a restart steer library call with that GSH
-  mMutexPtr->lock();
-  Emit_restart_cmd(mSimHandle, (char*)text.latin1());
-  mMutexPtr->unlock();
+  mExecutor->call(REG_CALL_SITE("Emit_restart_cmd"),
+		  boost::bind(Emit_restart_cmd, mSimHandle,
+			      (char*)text.latin1()));
 #endif // def REG_WSRF
 #endif // 0
 
@@ -736,6 +862,50 @@ int Application::getHandle(){
   return mSimHandle;
 }
 
+boost::shared_ptr<HistorySpool> Application::getHistorySpool(){
+  return mHistorySpool;
+}
+
+HistoryTable *Application::getHistoryTable(){
+  return &mHistoryTable;
+}
+
+HistoryCache *Application::getHistoryCache(){
+  return mHistoryCacheLoader ? NULL : mHistoryCache.get();
+}
+
+void Application::saveHistoryCache(){
+  if(!mHistoryCache || mHistorySaved)
+    return;
+  mHistorySaved = true;
+
+  // anything still being loaded has to be saved with the rest
+  finishLoadingHistoryCache();
+
+  // don't lose the histories we had for want of any new ones
+  if(mHistoryTable.getNumRows() + mHistoryTable.getNumLogRows() == 0)
+    return;
+
+  HistoryCache::SeriesMap lSeries;
+  mControlForm->getHistoryTimelines(lSeries);
+  mHistoryCache->save(lSeries);
+}
+
+void Application::finishLoadingHistoryCache(){
+  if(!mHistoryCacheLoader)
+    return;
+
+  mHistoryCacheLoader->wait();
+  delete mHistoryCacheLoader;
+  mHistoryCacheLoader = kNULL;
+
+  // hand the histories to the parameters we already have; any others
+  // get theirs as they turn up, unless the log has been fetched
+  mControlForm->useCachedHistories();
+  if(mHistoryLogFetched)
+    mHistoryCache->clear();
+}
+
 void Application::setCurrentStatus(QString &msg){
   mStatusTxt = msg;
 }
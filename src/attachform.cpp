@@ -75,6 +75,9 @@
 #include "utility.h"
 #include "types.h"
 #include "debug.h"
+#include "regexecutor.h"
+
+#include <boost/bind.hpp>
 
 #include "ReG_Steer_Steerside.h"
 #include "ReG_Steer_Browser.h"
@@ -128,9 +131,11 @@ AttachForm::AttachForm(QWidget *parent, const char *name,
   }
   // Now find out what's in the registry...
   //..._secure only available in steering library >= 2.0
-  mLibReturnStatus = Get_registry_entries_secure(lConfig->mTopLevelRegistry,
-						 &(lConfig->mRegistrySecurity),
-						 &content);
+  QByteArray lRegistry = lConfig->mTopLevelRegistry.toAscii();
+  mLibReturnStatus = ((SteererMainWindow *)parent)->getExecutor()->
+    call(REG_CALL_SITE("Get_registry_entries_secure"),
+	 boost::bind(Get_registry_entries_secure, lRegistry.data(),
+		     &(lConfig->mRegistrySecurity), &content));
 // #else
 //   mLibReturnStatus = Get_registry_entries((char *)(lConfig->mTopLevelRegistry.ascii()),
 // 					  &content);
@@ -57,7 +57,6 @@
 #include <qpushbutton.h>
 #include <qtooltip.h>
 #include <q3vbox.h>
-#include <qmutex.h>
 //Added by qt3to4:
 #include <Q3HBoxLayout>
 #include <Q3VBoxLayout>
@@ -68,13 +67,16 @@
 #include "utility.h"
 #include "types.h"
 #include "debug.h"
+#include "regexecutor.h"
+
+#include <boost/bind.hpp>
 
 ChkPtForm::ChkPtForm(const int aNumEntries, int aSimHandle, int aChkPtHandle,
-		     QMutex *aMutex, QWidget *parent, const char *name,
+		     ReGExecutor *aExecutor, QWidget *parent, const char *name,
 		     bool modal, Qt::WFlags f)
   : QDialog( parent, name, modal, f ), mNumEntries(aNumEntries), mLibReturnStatus(REG_SUCCESS),
     mIndexSelected(-1), mListBox(kNULL), mFilterLineEdit(kNULL),
-    mRestartButton(kNULL), mCancelButton(kNULL), mMutexPtr(aMutex)
+    mRestartButton(kNULL), mCancelButton(kNULL), mExecutor(aExecutor)
 {
 
   REG_DBGCON("ChkPtForm");
@@ -83,9 +85,10 @@ ChkPtForm::ChkPtForm(const int aNumEntries, int aSimHandle, int aChkPtHandle,
   mLogEntries = new Output_log_struct[mNumEntries];
 
   // get the log entries from library
-  mMutexPtr->lock();
-  mLibReturnStatus = Get_chk_log_entries(aSimHandle, aChkPtHandle, mNumEntries, mLogEntries); //ReG library
-  mMutexPtr->unlock();
+  mLibReturnStatus = mExecutor->call(REG_CALL_SITE("Get_chk_log_entries"), //ReG library
+				     boost::bind(Get_chk_log_entries,
+						 aSimHandle, aChkPtHandle,
+						 mNumEntries, mLogEntries));
 
   // only continue is there is some info to show
   if(mLibReturnStatus == REG_SUCCESS)
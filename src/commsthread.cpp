@@ -52,11 +52,11 @@
     @brief Contains the implementation of the thread that polls for messages
     from the steered application(s)
 
-    CommsThread and CommsThreadEvent classes for QT steerer GUI.
+    CommsThread class for QT steerer GUI.
     CommsThread periodically calls the ReG library routines to look for
-    information received from steered applications.  CommsThreadEvent
-    encapsulates an event to communicate to the GUI thread that it must
-    process information from the steered application.
+    information received from steered applications and passes the type
+    of each message on to its Application, which processes it in the
+    GUI thread.
 
     @author Sue Ramsden
     @author Mark Riding
@@ -68,12 +68,17 @@
 #include <QCustomEvent>
 #include <QCoreApplication>
 
+#include <algorithm>
+#include <boost/bind.hpp>
+
 #include "buildconfig.h"
 #include "types.h"
 #include "debug.h"
 #include "commsthread.h"
 #include "steerermainwindow.h"
 #include "application.h"
+#include "steererconfig.h"
+#include "tracerecorder.h"
 
 #include "ReG_Steer_Steerside.h"
 
@@ -81,6 +86,25 @@
 //when catch signal.
 CommsThread *gCommsThreadPtr;
 
+/// The name to trace the handling of a message under
+static const char *consumeCallName(const int aMsgType)
+{
+  switch(aMsgType){
+  case IO_DEFS:
+    return "Consume_IOType_defs";
+  case CHK_DEFS:
+    return "Consume_ChkType_defs";
+  case PARAM_DEFS:
+    return "Consume_param_defs";
+  case STATUS:
+    return "Consume_status";
+  case STEER_LOG:
+    return "Consume_log";
+  default:
+    return "handleNextMessage";
+  }
+}
+
 extern "C" void threadSignalHandler(int aSignal)
 {
 
@@ -129,21 +153,92 @@ extern "C" void threadSignalHandler(int aSignal)
   gCommsThreadPtr->handleSignal();
 }
 
-CommsThread::CommsThread(SteererMainWindow *aSteerer, QMutex *aMutex,
+/// Get_param_number and Get_param_values in one go, so that both are
+/// run by the ReGExecutor without anything in between
+static int getParamDetails(const int aSimHandle, const bool aSteeredFlag,
+			   std::vector<Param_details_struct> *aDetails)
+{
+  int lNumParams = 0;
+
+  if(Get_param_number(aSimHandle, aSteeredFlag, &lNumParams)
+     != REG_SUCCESS)  //ReG library
+    return REG_FAILURE;
+
+  aDetails->resize(lNumParams > 0 ? lNumParams : 0);
+  if(lNumParams <= 0)
+    return REG_SUCCESS;
+
+  return Get_param_values(aSimHandle, aSteeredFlag, lNumParams,  //ReG library
+			  &(*aDetails)[0]);
+}
+
+/// Get_iotype_number and Get_iotypes (or the ChkType equivalents) in
+/// one go, so that both are run by the ReGExecutor without anything
+/// in between
+static int getIOTypeDetails(const int aSimHandle, const bool aChkPtType,
+			    std::vector<int> *aHandles,
+			    std::vector<QString> *aLabels,
+			    std::vector<int> *aTypes,
+			    std::vector<int> *aVals)
+{
+  int lNumTypes = 0;
+  int lStatus;
+
+  if(aChkPtType)
+    lStatus = Get_chktype_number(aSimHandle, &lNumTypes);	//ReG library
+  else
+    lStatus = Get_iotype_number(aSimHandle, &lNumTypes);	//ReG library
+
+  if(lStatus != REG_SUCCESS)
+    return lStatus;
+  if(lNumTypes <= 0)
+    return REG_SUCCESS;
+
+  // REG_MAX_STRING_LENGTH is the max string length imposed by library
+  std::vector<char> lLabelBuf(lNumTypes * (REG_MAX_STRING_LENGTH + 1));
+  std::vector<char*> lLabels(lNumTypes);
+  for(int i=0; i<lNumTypes; i++)
+    lLabels[i] = &lLabelBuf[i * (REG_MAX_STRING_LENGTH + 1)];
+
+  aHandles->resize(lNumTypes);
+  aTypes->resize(lNumTypes);
+  aVals->resize(lNumTypes);
+
+  if(aChkPtType)
+    lStatus = Get_chktypes(aSimHandle, lNumTypes, &(*aHandles)[0],	//ReG library
+			   &lLabels[0], &(*aTypes)[0], &(*aVals)[0]);
+  else
+    lStatus = Get_iotypes(aSimHandle, lNumTypes, &(*aHandles)[0],	//ReG library
+			  &lLabels[0], &(*aTypes)[0], &(*aVals)[0]);
+
+  if(lStatus != REG_SUCCESS)
+    return lStatus;
+
+  aLabels->resize(lNumTypes);
+  for(int i=0; i<lNumTypes; i++)
+    (*aLabels)[i] = lLabels[i];
+
+  return REG_SUCCESS;
+}
+
+CommsThread::CommsThread(SteererMainWindow *aSteerer, ReGExecutor *aExecutor,
 			 int aCheckInterval)
   : mSteerer(aSteerer), mKeepRunningFlag(true),
-    mCheckInterval(aCheckInterval), mMutexPtr(aMutex)
+    mCheckInterval(aCheckInterval), mExecutor(aExecutor),
+    mScheduler(aCheckInterval,
+	       (int)(1000.0*aSteerer->getConfig()->mLatencyTargetSecs))
 {
   REG_DBGCON("CommsThread constructor");
   gCommsThreadPtr = this;
   // Set polling interval automatically
   mUseAutoPollInterval = aSteerer->autoPollingOn();
-  mPollCount = 0;
-  mMsgCount = 0;
-  // How many polls to average over in order to decide whether
-  // or not to adjust the polling interval
-  mPollAdjustInterval = 10;
-  mMinPollAdjustInterval = 10;
+  mScheduler.setAutoAdjust(mUseAutoPollInterval);
+  // Limits on how much to handle in one go
+  mDrainMaxMessages = aSteerer->getConfig()->mDrainMaxMessages;
+  mDrainMaxMsecs = (int)(1000.0*aSteerer->getConfig()->mDrainMaxSecs);
+  // How far the GUI can fall behind
+  mHistoryOnlyDepth = aSteerer->getConfig()->mHistoryOnlyDepth;
+  mLatencyStats = aSteerer->getLatencyStats();
 
   signal(SIGINT, threadSignalHandler);	//ctrl-c
   signal(SIGTERM, threadSignalHandler);	//kill (note cannot (and should not) catch kill -9)
@@ -181,26 +276,52 @@ CommsThread::setCheckInterval(const int aInterval)
     mCheckInterval = aInterval;
   else
     mCheckInterval = kMIN_POLLING_INT;
+
+  mScheduler.setInterval(mCheckInterval);
+
+  // don't wait for the end of the old interval
+  mWaiter.wakeup();
 }
 
 int
 CommsThread::getCheckInterval() const
 {
- return mCheckInterval;
+ return mScheduler.getInterval();
+}
+
+void
+CommsThread::setLatencyTarget(const int aLatencyTarget)
+{
+  mScheduler.setLatencyTarget(aLatencyTarget < kMIN_POLLING_INT ?
+			      kMIN_POLLING_INT : aLatencyTarget);
+  mWaiter.wakeup();
+}
+
+int
+CommsThread::getLatencyTarget() const
+{
+  return mScheduler.getLatencyTarget();
+}
+
+bool
+CommsThread::getPollStats(const int aSimHandle,
+			  PollScheduler::AppStats &aStats) const
+{
+  return mScheduler.getStats(aSimHandle, aStats);
 }
 
 void
 CommsThread::stop()
 {
-  // flag thread to stop running (get out of while loop)
+  // flag thread to stop running (get out of while loop) and cut
+  // short any sleep it is in the middle of
   setKeepRunning(false);
+  mWaiter.wakeup();
 
-  // thread must have finished running before destruction - so wait for finish
-  while (!isFinished())
-  {
-    REG_DBGMSG("CommsThread::stop() - waiting for run completion");
-    wait(1000);  //1000 milliseconds
-  }
+  // thread must have finished running before destruction - so wait
+  // for finish. It is only ever in the middle of a single message now.
+  REG_DBGMSG("CommsThread::stop() - waiting for run completion");
+  wait();
   REG_DBGMSG("CommsThread: Thread is stopped");
 
   // reset flag for next run()
@@ -213,253 +334,580 @@ CommsThread::run()
 {
   // this is the routine that is call when CommsThread->start() is called.
   // this routine runs until flagged to stop
-  Application *lApp;
-  bool  lrecvdFirstStatusMsg = false;
-  int	lSimHandle = REG_SIM_HANDLE_NOTSET ;
   int   lMsgType = MSG_NOTSET;
-  float lPollRatio;
-  int   app_seqnum;
-  int   num_cmds = 0;
-  int   status = REG_FAILURE;
-  int   commands[REG_MAX_NUM_STR_CMDS];
-  const float maxSuccessFraction = 0.9f;
-  const float minSuccessFraction = 0.6f;
+  int   lFirstMsgType = MSG_NOTSET;
+  int   lSimHandle = REG_SIM_HANDLE_NOTSET;
+  bool  lFromPaused = false;
+  int   lBatchCount;
+  int64_t lBatchStart;
+  bool  lDescriptorReady = false;
+  bool  lSpuriousWakeup = false;
 
   REG_DBGMSG("CommsThread starting");
+  TraceRecorder::setThreadName("CommsThread");
 
-  // add sleep to give GUI chance to finsh posting new form SMR XXX thread bug fix
-  msleep(1000);
+  // Don't poll until the GUI has finished setting up the form for
+  // the first application - addApplication() tells us when it has
+  while(mKeepRunningFlag && !hasApplications())
+    mWaiter.wait(kMAX_POLLING_INT, false);
+  REG_DBGMSG("CommsThread: first application ready");
 
   // keep running until flagged to stop
   while (mKeepRunningFlag)
   {
-    // This section automatically adjusts the polling interval
-    // to keep up with the attached application(s)
-    if(lrecvdFirstStatusMsg && mUseAutoPollInterval &&
-       (mPollCount == mPollAdjustInterval)){
-
-      lPollRatio = (float)mMsgCount/(float)mPollCount;
-      //cout << "CommsThread: mMsgCount = " << mMsgCount << endl;
-      //cout << "CommsThread: mPollCount = " << mPollCount << endl;
-      //cout << "CommsThread: poll ratio = " << lPollRatio << endl;
-      //cout << "CommsThread: interval = " << mCheckInterval << endl;
-      if(lPollRatio > maxSuccessFraction){
-
-	if(mCheckInterval > kMIN_POLLING_INT){
-	  // Reduce polling interval faster than we increase it
-	  mCheckInterval -= (int)(0.35*mCheckInterval);
-	  //cout << "CommsThread: reducing poll interval to "
-	  //     << mCheckInterval << endl;
-	  // Adjust how many calls we average over to try and ensure
-	  // we check about every 2 seconds
-	  mPollAdjustInterval = (int)(1500.0/(float)mCheckInterval);
-	  if(mPollAdjustInterval < mMinPollAdjustInterval){
-	    mPollAdjustInterval = mMinPollAdjustInterval;
-	  }
-	  //cout << "CommsThread: poll adjust interval = " <<
-	  //  mPollAdjustInterval << endl;
-	}
-      }
-      else if(lPollRatio < minSuccessFraction){
-
-	if(mCheckInterval < kMAX_POLLING_INT){
-	  // Not getting messages very often so increase the interval
-	  // between polls
-	  mCheckInterval += (int)(0.2*mCheckInterval) + 1;
-	  //cout << "CommsThread: increasing poll interval to " <<
-	  //  mCheckInterval << endl;
-	  // Adjust how many calls we average over to try and ensure
-	  // we check about every 2 seconds
-	  mPollAdjustInterval = (int)(1500.0/(float)mCheckInterval);
-	  if(mPollAdjustInterval < mMinPollAdjustInterval){
-	    mPollAdjustInterval = mMinPollAdjustInterval;
-	  }
-	  //cout << "CommsThread: poll adjust interval = " <<
-	  //  mPollAdjustInterval << endl;
-	}
-      }
-      mPollCount = 0;
-      mMsgCount = 0;
+    // Handle messages until there are none left, or until we've
+    // spent our budget, so that a burst is cleared in one go rather
+    // than one message per polling interval. Only the first poll of
+    // a batch counts towards the hit ratios, but every status message
+    // counts towards the time between an application's messages.
+    // A message from an application that is paused because its GUI
+    // has fallen behind ends the batch, so that it is only read as
+    // often as the others are polled.
+    lBatchStart = mClock.getTime64();
+    lBatchCount = 0;
+    TraceScope lPollTrace("comms", "poll");
+    do{
+      lMsgType = handleNextMessage(lBatchCount == 0, lSimHandle);
+      lFromPaused = (lMsgType != MSG_NOTSET) && (lMsgType != MSG_ERROR) &&
+	isPaused(lSimHandle);
+      if(lBatchCount == 0)
+	lFirstMsgType = lMsgType;
+      lBatchCount++;
+    } while(mKeepRunningFlag && (lMsgType != MSG_NOTSET) &&
+	    (lMsgType != MSG_ERROR) && !lFromPaused &&
+	    (lBatchCount < mDrainMaxMessages) &&
+	    (mClock.getTime64() - lBatchStart < mDrainMaxMsecs));
+    lPollTrace.finish();
+
+    // A descriptor that says it is readable but gives us no message
+    // is most likely a peer that has gone away - it would stay
+    // readable for ever so don't watch descriptors for one interval.
+    lSpuriousWakeup = lDescriptorReady && (lFirstMsgType == MSG_NOTSET);
+    lDescriptorReady = false;
+
+    if(lMsgType == MSG_ERROR)
+      continue;
+
+    if(lMsgType != MSG_NOTSET && !lFromPaused){
+      // Budget used up with messages still waiting - let the GUI
+      // thread at the library before carrying on
+      yieldCurrentThread();
+      continue;
     }
 
-    // reset lMsgType
-    lMsgType = MSG_NOTSET;
+    // sleep until the next application is due to be polled or until
+    // woken - either by another thread or by a watched descriptor
+    // becoming readable. If every application can wake us there is no
+    // need to poll on a timer so just use a long safety-net interval,
+    // unless the descriptors aren't being watched this time round.
+    const bool lUseSafetyNet = allApplicationsWatched() && !lSpuriousWakeup;
+    lDescriptorReady = mWaiter.wait(lUseSafetyNet ?
+				    kMAX_POLLING_INT :
+				    mScheduler.msecsUntilDue(mCheckInterval),
+				    !lSpuriousWakeup);
+
+    // Directory events are consumed here rather than by the library
+    // so they can't leave the descriptor readable. They may be our
+    // own writes, so don't count them as a spurious wakeup either.
+    if(drainDirWatcher())
+      lDescriptorReady = false;
 
-    // hold qt library mutex for library call
-    mMutexPtr->lock();
-    // Get_next_message always returns  REG_SUCCESS currently
-    if (Get_next_message(&lSimHandle, &lMsgType) != REG_SUCCESS){  //ReG library
-      mMutexPtr->unlock();
-      REG_DBGEXCP("Get_next_message error");
-    }
-    mMutexPtr->unlock();
+  }
+  REG_DBGMSG("Leaving CommsThread::run");
+}
 
-    if(!lrecvdFirstStatusMsg){
-      lrecvdFirstStatusMsg = (lMsgType == STATUS);
-    }
+int
+CommsThread::handleNextMessage(const bool aRecordPoll, int &aSimHandle)
+{
+  int	lSimHandle = REG_SIM_HANDLE_NOTSET;
+  int   lMsgType = MSG_NOTSET;
+  int   app_seqnum = -1;
+  int   num_cmds = 0;
+  int   status = REG_FAILURE;
+  int   commands[REG_MAX_NUM_STR_CMDS];
+  LatencyStats::Stamps lStamps;
 
-    // Protect this count to prevent overflow when not using auto. poll interv.
-    if(mUseAutoPollInterval && lrecvdFirstStatusMsg)mPollCount++;
+  // Get_next_message always returns  REG_SUCCESS currently
+  if (mExecutor->call(REG_CALL_SITE("Get_next_message"),
+		      boost::bind(Get_next_message, &lSimHandle,
+				  &lMsgType)) != REG_SUCCESS){  //ReG library
+    REG_DBGEXCP("Get_next_message error");
+  }
+  lStamps.mReceived = mLatencyStats->now();
+  aSimHandle = lSimHandle;
+  TraceScope lConsumeTrace("comms", consumeCallName(lMsgType), lSimHandle);
+
+  // let the scheduler adjust the polling interval(s) to keep up
+  // with the attached application(s) - it learns from every message
+  // but only from the first poll after a sleep
+  if(lMsgType != MSG_NOTSET && lMsgType != MSG_ERROR)
+    mScheduler.recordMessage(lSimHandle, lMsgType);
+  if(aRecordPoll)
+    mScheduler.recordPoll(lSimHandle, lMsgType);
+
+  if(lMsgType == MSG_ERROR){
+    REG_DBGMSG("CommsThread: Got error when attempting to get "
+	       "next message");
+    return lMsgType;
+  }
 
-    if(lMsgType == MSG_ERROR){
-      REG_DBGMSG("CommsThread: Got error when attempting to get "
-		 "next message");
-      continue;
-    }
+  if (lMsgType != MSG_NOTSET){
 
-    if (lMsgType != MSG_NOTSET){
+    switch(lMsgType){
 
-      // Protect this count to prevent overflow when not using auto.
-      // poll interval
-      if(mUseAutoPollInterval)mMsgCount++;
+    case IO_DEFS:
 
-      switch(lMsgType){
+      REG_DBGMSG("CommsThread: Got IOdefs message");
 
-      case IO_DEFS:
+      status = mExecutor->call(REG_CALL_SITE("Consume_IOType_defs"),	//ReG library
+			       boost::bind(Consume_IOType_defs, lSimHandle));
+      break;
 
-	REG_DBGMSG("CommsThread: Got IOdefs message");
+    case CHK_DEFS:
 
-	// hold qt library mutex for library call
-	mMutexPtr->lock();
-	status = Consume_IOType_defs(lSimHandle); //ReG library
-	mMutexPtr->unlock();
-	break;
+      REG_DBGMSG("CommsThread: Got Chkdefs message");
+      status = mExecutor->call(REG_CALL_SITE("Consume_ChkType_defs"),	//ReG library
+			       boost::bind(Consume_ChkType_defs, lSimHandle));
+      break;
 
-      case CHK_DEFS:
+    case PARAM_DEFS:
 
-	REG_DBGMSG("CommsThread: Got Chkdefs message");
-	mMutexPtr->lock();
-	status = Consume_ChkType_defs(lSimHandle); //ReG library
-	mMutexPtr->unlock();
-	break;
+      REG_DBGMSG("CommsThread: Got param defs message");
+      status = mExecutor->call(REG_CALL_SITE("Consume_param_defs"),	//ReG library
+			       boost::bind(Consume_param_defs, lSimHandle));
+      break;
 
-      case PARAM_DEFS:
+    case STATUS:
 
-	REG_DBGMSG("CommsThread: Got param defs message");
-	mMutexPtr->lock();
-	status = Consume_param_defs(lSimHandle); //ReG library
-	mMutexPtr->unlock();
-	break;
+      REG_DBGMSG("CommsThread: Got status message");
+      status = mExecutor->call(REG_CALL_SITE("Consume_status"),	//ReG library
+			       boost::bind(Consume_status, lSimHandle,
+					   &app_seqnum, &num_cmds,
+					   &commands[0]));
+      break;
 
-      case STATUS:
+    case STEER_LOG:
+      REG_DBGMSG("CommsThread: Got steer_log message");
+      status = mExecutor->call(REG_CALL_SITE("Consume_log"),	//ReG library
+			       boost::bind(Consume_log, lSimHandle));
+      break;
 
-	REG_DBGMSG("CommsThread: Got status message");
-	mMutexPtr->lock();
-	status = Consume_status(lSimHandle,   //ReG library
-				&app_seqnum,
-				&num_cmds, commands);
-	mMutexPtr->unlock();
-	break;
+    case MSG_NOTSET:
+      REG_DBGMSG("CommsThread: No msg to process");
+      break;
 
-      case STEER_LOG:
-	REG_DBGMSG("CommsThread: Got steer_log message");
-	mMutexPtr->lock();
-	status = Consume_log(lSimHandle);   //ReG library
-	mMutexPtr->unlock();
-	break;
+    case CONTROL:
+      REG_DBGMSG("CommsThread: Got control message");
+      break;
 
-      case MSG_NOTSET:
-	REG_DBGMSG("CommsThread: No msg to process");
-	break;
+    case SUPP_CMDS:
+      REG_DBGMSG("CommsThread: Got supp_cmds message");
+      break;
 
-      case CONTROL:
-	REG_DBGMSG("CommsThread: Got control message");
-	break;
+    default:
+      cout << "Unrecognised msg returned by Get_next_message: " <<
+	lMsgType << endl;
+      break;
 
-      case SUPP_CMDS:
-	REG_DBGMSG("CommsThread: Got supp_cmds message");
-	break;
+    } //switch(aMsgType)
+
+    lStamps.mConsumed = mLatencyStats->now();
+    lConsumeTrace.finish();
+
+    // Read what the GUI needs from the library now. Only tell the GUI
+    // if it hasn't already got an update from this application
+    // waiting to be processed - if it has then this one is merged
+    // into it.
+    if(status == REG_SUCCESS &&
+       (lMsgType == IO_DEFS || lMsgType == CHK_DEFS ||
+	lMsgType == PARAM_DEFS || lMsgType == STATUS) &&
+       !queueUpdate(lSimHandle, lMsgType, app_seqnum, num_cmds, commands)){
+      // merged into an update the GUI already knows about
+      mLatencyStats->record(lSimHandle, lMsgType, lStamps);
+      return lMsgType;
+    }
 
-      default:
-	cout << "Unrecognised msg returned by Get_next_message: " <<
-	  lMsgType << endl;
-	break;
+    if(status == REG_SUCCESS){
+      // hand the message to the application - the main GUI thread
+      // will process it and not this commsthread.
+      // this avoids any locking issues around GUI funcs (i think)
+
+      // ARPDBG - attempt to avoid lock-up on shutdown
+      if(mKeepRunningFlag){
+
+	// The queue only fills up if the GUI has fallen a long way
+	// behind, in which case wait for it rather than lose the
+	// message. The application is looked up every time as it may
+	// be closed in the meantime.
+	lStamps.mQueued = mLatencyStats->now();
+	TraceScope lPostTrace("comms", "postMessage", lSimHandle);
+	PostResult lPosted;
+	while((lPosted = postToApplication(lSimHandle, lMsgType, lStamps))
+	      == kQUEUE_FULL && mKeepRunningFlag)
+	  msleep(1);
+	// addApplication() posts any update left pending here
+	if(lPosted == kNO_APPLICATION)
+	  REG_DBGMSG("CommsThread::handleNextMessage: NULL application pointer!");
+      }
+    }
+  }
 
-      } //switch(aMsgType)
+  return lMsgType;
+}
 
-      if(status == REG_SUCCESS){
-	// create event and post it - posting means the main GUI
-	// thread will process the event and not this commsthread.
-	// this avoids any locking issues around GUI funcs (i think)
-	lApp = mSteerer->getApplication(lSimHandle);
+bool
+CommsThread::queueUpdate(const int aSimHandle, const int aMsgType,
+			 const int aSeqNum, const int aNumCmds,
+			 const int *aCommands)
+{
+  TraceScope lTrace("comms", "queueUpdate", aSimHandle);
+  StatusUpdate lNew;
 
-	// ARPDBG - attempt to avoid lock-up on shutdown
-	if(lApp && mKeepRunningFlag){
+  // Status messages change parameter values and IO/Chk frequencies
+  if(aMsgType == PARAM_DEFS || aMsgType == STATUS){
+    lNew.mHaveParams = getParamStates(aSimHandle, false, lNew.mMonParams) &&
+      getParamStates(aSimHandle, true, lNew.mSteerParams);
+  }
+  if(aMsgType == IO_DEFS || aMsgType == STATUS)
+    lNew.mHaveIOTypes = getIOTypeStates(aSimHandle, false, lNew.mIOTypes);
+  if(aMsgType == CHK_DEFS || aMsgType == STATUS)
+    lNew.mHaveChkTypes = getIOTypeStates(aSimHandle, true, lNew.mChkTypes);
+
+  // The library only keeps the latest values so log them now in case
+  // the GUI doesn't get round to it before the next status
+  if(aMsgType == STATUS && lNew.mHaveParams){
+    StatusRecord lRecord;
+    lRecord.mSeqNum = aSeqNum;
+    addToRecord(lNew.mMonParams, lRecord);
+    addToRecord(lNew.mSteerParams, lRecord);
+    lNew.mRecords.push_back(lRecord);
+  }
 
-	  CommsThreadEvent *lEvent = new CommsThreadEvent(lMsgType);
-	  if(num_cmds)lEvent->storeCommands(num_cmds, commands);
-	  QCoreApplication::postEvent(lApp, lEvent);
-	}
-	else{
-	  REG_DBGMSG("CommsThread::run: NULL application pointer!");
-	}
-      }
-    }
-    msleep(mCheckInterval);  // sleep for mCheckInterval milliseconds
+  QMutexLocker lLock(&mStatusMutex);
+  bool lIsNew = (mPendingStatus.find(aSimHandle) == mPendingStatus.end());
+  StatusUpdate &lUpdate = mPendingStatus[aSimHandle];
 
+  // newer state replaces older, history and commands accumulate
+  if(lNew.mHaveParams){
+    lUpdate.mMonParams.swap(lNew.mMonParams);
+    lUpdate.mSteerParams.swap(lNew.mSteerParams);
+    lUpdate.mHaveParams = true;
   }
-  REG_DBGMSG("Leaving CommsThread::run");
+  if(lNew.mHaveIOTypes){
+    lUpdate.mIOTypes.swap(lNew.mIOTypes);
+    lUpdate.mHaveIOTypes = true;
+  }
+  if(lNew.mHaveChkTypes){
+    lUpdate.mChkTypes.swap(lNew.mChkTypes);
+    lUpdate.mHaveChkTypes = true;
+  }
+  lUpdate.mRecords.insert(lUpdate.mRecords.end(),
+			  lNew.mRecords.begin(), lNew.mRecords.end());
+  lUpdate.mCommands.insert(lUpdate.mCommands.end(),
+			   aCommands, aCommands + aNumCmds);
+  lLock.unlock();
+
+  // If the GUI can't keep up even in history-only mode stop polling
+  // this application until it does, rather than let the backlog grow
+  // without bound. The others carry on being polled as before.
+  if(!lIsNew && pendingRecords(aSimHandle) >=
+     kMAX_PENDING_FACTOR * mHistoryOnlyDepth)
+    setPaused(aSimHandle, true);
+
+  return lIsNew;
 }
 
-void
-CommsThread::setKeepRunning(const bool aFlag)
+unsigned int
+CommsThread::pendingRecords(const int aSimHandle) const
 {
-  // flag to get out of while loop in run()
-  mKeepRunningFlag = aFlag;
+  QMutexLocker lLock(&mStatusMutex);
+  std::map<int, StatusUpdate>::const_iterator lIt =
+    mPendingStatus.find(aSimHandle);
+
+  return (lIt == mPendingStatus.end()) ? 0 : lIt->second.mRecords.size();
 }
 
-bool CommsThread::getUseAutoPollFlag() const
+bool
+CommsThread::getParamStates(const int aSimHandle, const bool aSteeredFlag,
+			    std::vector<ParamState> &aParams)
 {
-  return mUseAutoPollInterval;
+  std::vector<Param_details_struct> lParamDetails;
+
+  if(mExecutor->call(aSteeredFlag ? REG_CALL_SITE("Get_param_values(steered)") :
+		     REG_CALL_SITE("Get_param_values(monitored)"),
+		     boost::bind(getParamDetails, aSimHandle, aSteeredFlag,
+				 &lParamDetails)) != REG_SUCCESS){
+    REG_DBGMSG("CommsThread::getParamStates: Get_param_values failed");
+    return false;
+  }
+
+  aParams.resize(lParamDetails.size());
+  for(unsigned int i=0; i<lParamDetails.size(); i++){
+    aParams[i].mHandle = lParamDetails[i].handle;
+    aParams[i].mType = lParamDetails[i].type;
+    aParams[i].mLabel = lParamDetails[i].label;
+    aParams[i].mParsed.parse(lParamDetails[i].type, lParamDetails[i].value);
+    aParams[i].mMinVal = lParamDetails[i].min_val;
+    aParams[i].mMaxVal = lParamDetails[i].max_val;
+  }
+  return true;
 }
 
-void CommsThread::setUseAutoPollFlag(const int aFlag)
+bool
+CommsThread::getIOTypeStates(const int aSimHandle, const bool aChkPtType,
+			     std::vector<IOTypeState> &aTypes)
 {
-  if(aFlag){
-    mMsgCount = 0;
-    mPollCount = 0;
+  std::vector<int> lHandles;
+  std::vector<int> lTypes;
+  std::vector<int> lVals;
+  std::vector<QString> lLabels;
+
+  if(mExecutor->call(aChkPtType ? REG_CALL_SITE("Get_chktypes") :
+		     REG_CALL_SITE("Get_iotypes"),
+		     boost::bind(getIOTypeDetails, aSimHandle, aChkPtType,
+				 &lHandles, &lLabels, &lTypes,
+				 &lVals)) != REG_SUCCESS){
+    REG_DBGMSG("CommsThread::getIOTypeStates: Get_iotypes failed");
+    return false;
   }
-  mUseAutoPollInterval = aFlag;
-  return;
+
+  aTypes.resize(lHandles.size());
+  for(unsigned int i=0; i<lHandles.size(); i++){
+    aTypes[i].mHandle = lHandles[i];
+    aTypes[i].mType = lTypes[i];
+    aTypes[i].mFrequency = lVals[i];
+    aTypes[i].mLabel = lLabels[i];
+  }
+  return true;
+}
+
+void
+CommsThread::addToRecord(const std::vector<ParamState> &aParams,
+			 StatusRecord &aRecord)
+{
+  for(unsigned int i=0; i<aParams.size(); i++){
+    if(!aParams[i].mParsed.isNumber())
+      continue;
+    aRecord.mHandles.push_back(aParams[i].mHandle);
+    aRecord.mValues.push_back(aParams[i].mParsed);
+  }
+}
+
+bool
+CommsThread::takeStatusUpdate(const int aSimHandle, StatusUpdate &aUpdate)
+{
+  QMutexLocker lLock(&mStatusMutex);
+  std::map<int, StatusUpdate>::iterator lIt = mPendingStatus.find(aSimHandle);
+
+  if(lIt == mPendingStatus.end())
+    return false;
+
+  std::swap(aUpdate, lIt->second);
+  mPendingStatus.erase(lIt);
+
+  // Go into history-only mode once the GUI has fallen behind and
+  // only come out once it has well and truly caught up
+  bool &lHistoryOnly = mHistoryOnly[aSimHandle];
+  if(aUpdate.mRecords.size() >= mHistoryOnlyDepth)
+    lHistoryOnly = true;
+  else if(aUpdate.mRecords.size() <= mHistoryOnlyDepth / 4)
+    lHistoryOnly = false;
+  aUpdate.mHistoryOnly = lHistoryOnly;
+  lLock.unlock();
+
+  // The backlog has been taken so it is safe to poll it again
+  setPaused(aSimHandle, false);
+
+  return true;
 }
 
+void
+CommsThread::wakeup()
+{
+  mWaiter.wakeup();
+}
 
-CommsThreadEvent::CommsThreadEvent(int aMsgType)
-  : QCustomEvent(QEvent::User + kMSG_EVENT), mMsgType(aMsgType)
+void
+CommsThread::addApplication(const int aSimHandle, Application *aApp,
+			    const int aFd, const QString &aSteerDir)
 {
-  // class to extend QCustomEvent to hold mMsgType
-  REG_DBGCON("CommsThreadEvent");
-  mNumCmds = 0;
+  AppWatch lWatch;
+  lWatch.mApp = aApp;
+  lWatch.mFd = aFd;
+  lWatch.mSteerDir = aSteerDir;
+  lWatch.mDirWatch = -1;
+  lWatch.mPaused = false;
+
+  mAppMutex.lock();
+  AppWatch &lNew = mAppWatches[aSimHandle];
+  lNew = lWatch;
+  watch(lNew, true);
+  mAppMutex.unlock();
+
+  mScheduler.addApplication(aSimHandle);
+
+  if(aFd >= 0)
+    REG_DBGMSG2("CommsThread: watching descriptor for sim ", aSimHandle, aFd);
+
+  // Messages can arrive between attaching and being added here. Any
+  // update queued for them has not been posted to the GUI and later
+  // ones would only be merged into it, so post it now. This is
+  // checked after the application is added so that either this or
+  // handleNextMessage() sees it.
+  mStatusMutex.lock();
+  bool lPending = (mPendingStatus.find(aSimHandle) != mPendingStatus.end());
+  mStatusMutex.unlock();
+  if(lPending){
+    LatencyStats::Stamps lStamps;
+    lStamps.mQueued = mLatencyStats->now();
+    postToApplication(aSimHandle, STATUS, lStamps);
+  }
+
+  // make sure the new application is noticed now rather than at the
+  // end of the current polling interval
+  mWaiter.wakeup();
 }
 
-CommsThreadEvent::~CommsThreadEvent()
+void
+CommsThread::removeApplication(const int aSimHandle)
 {
-  REG_DBGDST("CommsThreadEvent");
+  mScheduler.removeApplication(aSimHandle);
+
+  mStatusMutex.lock();
+  mPendingStatus.erase(aSimHandle);
+  mHistoryOnly.erase(aSimHandle);
+  mStatusMutex.unlock();
+
+  QMutexLocker lLock(&mAppMutex);
+  std::map<int, AppWatch>::iterator lIt = mAppWatches.find(aSimHandle);
+
+  if(lIt == mAppWatches.end())
+    return;
+
+  if(!lIt->second.mPaused)
+    watch(lIt->second, false);
+
+  mAppWatches.erase(lIt);
+
+  // the sleep may have been calculated for this application
+  mWaiter.wakeup();
 }
 
-/** Returns the type of the message that generated this event */
-int
-CommsThreadEvent::getMsgType() const
+bool
+CommsThread::hasApplications() const
 {
-  return mMsgType;
+  QMutexLocker lLock(&mAppMutex);
+  return !mAppWatches.empty();
 }
 
-/** Copy the array of commands into internal storage */
-void CommsThreadEvent::storeCommands(int aNum, int *aArray)
+bool
+CommsThread::allApplicationsWatched() const
 {
-  int i;
-  mNumCmds = aNum;
-  for(i=0; i<mNumCmds; i++){
-    mCommands[i] = aArray[i];
+  QMutexLocker lLock(&mAppMutex);
+  std::map<int, AppWatch>::const_iterator lIt;
+
+  if(mAppWatches.empty())
+    return false;
+
+  // paused applications aren't polled anyway
+  for(lIt = mAppWatches.begin(); lIt != mAppWatches.end(); ++lIt){
+    if(!lIt->second.mPaused &&
+       lIt->second.mFd < 0 && lIt->second.mDirWatch < 0)
+      return false;
   }
+  return true;
 }
 
-int CommsThreadEvent::getNumCmds() const
+void
+CommsThread::watch(AppWatch &aWatch, const bool aOn)
 {
-  return mNumCmds;
+  if(aWatch.mFd >= 0){
+    if(aOn)
+      mWaiter.addDescriptor(aWatch.mFd);
+    else
+      mWaiter.removeDescriptor(aWatch.mFd);
+  }
+
+  int lOldFd = mDirWatcher.descriptor();
+  if(aOn && !aWatch.mSteerDir.isEmpty()){
+    aWatch.mDirWatch = mDirWatcher.addDirectory(aWatch.mSteerDir);
+    if(lOldFd < 0 && mDirWatcher.descriptor() >= 0)
+      mWaiter.addDescriptor(mDirWatcher.descriptor());
+  }
+  else if(!aOn && aWatch.mDirWatch >= 0){
+    mDirWatcher.removeDirectory(aWatch.mDirWatch);
+    aWatch.mDirWatch = -1;
+    if(mDirWatcher.descriptor() < 0)
+      mWaiter.removeDescriptor(lOldFd);
+  }
 }
 
-int *CommsThreadEvent::getCmdsPtr()
+void
+CommsThread::setPaused(const int aSimHandle, const bool aPaused)
 {
-  return mCommands;
+  QMutexLocker lLock(&mAppMutex);
+  std::map<int, AppWatch>::iterator lIt = mAppWatches.find(aSimHandle);
+
+  if(lIt == mAppWatches.end() || lIt->second.mPaused == aPaused)
+    return;
+
+  REG_DBGMSG2("CommsThread: polling paused for sim ", aSimHandle, aPaused);
+  lIt->second.mPaused = aPaused;
+  watch(lIt->second, !aPaused);
+  mScheduler.setPaused(aSimHandle, aPaused);
+
+  // it is due straight away
+  if(!aPaused)
+    mWaiter.wakeup();
 }
+
+bool
+CommsThread::isPaused(const int aSimHandle) const
+{
+  QMutexLocker lLock(&mAppMutex);
+  std::map<int, AppWatch>::const_iterator lIt = mAppWatches.find(aSimHandle);
+
+  return lIt != mAppWatches.end() && lIt->second.mPaused;
+}
+
+CommsThread::PostResult
+CommsThread::postToApplication(const int aSimHandle, const int aMsgType,
+			       const LatencyStats::Stamps &aStamps)
+{
+  QMutexLocker lLock(&mAppMutex);
+  std::map<int, AppWatch>::const_iterator lIt = mAppWatches.find(aSimHandle);
+
+  if(lIt == mAppWatches.end() || !lIt->second.mApp)
+    return kNO_APPLICATION;
+
+  return lIt->second.mApp->postMessage(aMsgType, aStamps) ?
+    kPOSTED : kQUEUE_FULL;
+}
+
+bool
+CommsThread::drainDirWatcher()
+{
+  QMutexLocker lLock(&mAppMutex);
+  return mDirWatcher.drain();
+}
+
+void
+CommsThread::setKeepRunning(const bool aFlag)
+{
+  // flag to get out of while loop in run()
+  mKeepRunningFlag = aFlag;
+}
+
+bool CommsThread::getUseAutoPollFlag() const
+{
+  return mUseAutoPollInterval;
+}
+
+void CommsThread::setUseAutoPollFlag(const int aFlag)
+{
+  mScheduler.setAutoAdjust(aFlag);
+  mUseAutoPollInterval = aFlag;
+  mWaiter.wakeup();
+  return;
+}
+
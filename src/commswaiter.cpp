@@ -0,0 +1,197 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file commswaiter.cpp
+    @brief Implementation of the CommsWaiter class
+    @author Robert Haines */
+
+#include "buildconfig.h"
+#include "commswaiter.h"
+#include "debug.h"
+
+#include <algorithm>
+#ifndef WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CommsWaiter::CommsWaiter()
+{
+#ifndef WIN32
+  if(pipe(mPipe) == 0) {
+    // Neither end may block: wakeup() is called with locks held and
+    // wait() drains the pipe until it is empty.
+    fcntl(mPipe[0], F_SETFL, fcntl(mPipe[0], F_GETFL) | O_NONBLOCK);
+    fcntl(mPipe[1], F_SETFL, fcntl(mPipe[1], F_GETFL) | O_NONBLOCK);
+  }
+  else {
+    REG_DBGMSG1("CommsWaiter: failed to create wakeup pipe, errno = ",
+		errno);
+    mPipe[0] = mPipe[1] = -1;
+  }
+#else
+  mWoken = false;
+#endif
+}
+
+CommsWaiter::~CommsWaiter()
+{
+#ifndef WIN32
+  if(mPipe[0] >= 0) close(mPipe[0]);
+  if(mPipe[1] >= 0) close(mPipe[1]);
+#endif
+}
+
+void
+CommsWaiter::addDescriptor(const int aFd)
+{
+  QMutexLocker lLock(&mMutex);
+  if(std::find(mFds.begin(), mFds.end(), aFd) == mFds.end())
+    mFds.push_back(aFd);
+}
+
+void
+CommsWaiter::removeDescriptor(const int aFd)
+{
+  QMutexLocker lLock(&mMutex);
+  mFds.erase(std::remove(mFds.begin(), mFds.end(), aFd), mFds.end());
+}
+
+bool
+CommsWaiter::hasDescriptors() const
+{
+  QMutexLocker lLock(&mMutex);
+  return !mFds.empty();
+}
+
+bool
+CommsWaiter::wait(const int aTimeout, const bool aWatchDescriptors)
+{
+#ifndef WIN32
+  std::vector<struct pollfd> lPollFds;
+  struct pollfd lPollFd;
+
+  lPollFd.fd = mPipe[0];
+  lPollFd.events = POLLIN;
+  lPollFd.revents = 0;
+  lPollFds.push_back(lPollFd);
+
+  if(aWatchDescriptors) {
+    mMutex.lock();
+    for(unsigned int i = 0; i < mFds.size(); i++) {
+      lPollFd.fd = mFds[i];
+      lPollFds.push_back(lPollFd);
+    }
+    mMutex.unlock();
+  }
+
+  int lReady = poll(&lPollFds[0], lPollFds.size(), aTimeout);
+  if(lReady <= 0) {
+    if(lReady < 0 && errno != EINTR) {
+      REG_DBGMSG1("CommsWaiter::wait: poll failed, errno = ", errno);
+    }
+    return false;
+  }
+
+  // Drain the wakeup pipe so the next wait() blocks again
+  if(lPollFds[0].revents & POLLIN) {
+    char lBuf[64];
+    while(read(mPipe[0], lBuf, sizeof(lBuf)) > 0);
+  }
+
+  for(unsigned int i = 1; i < lPollFds.size(); i++) {
+    if(lPollFds[i].revents & (POLLIN | POLLHUP | POLLERR))
+      return true;
+  }
+  return false;
+#else
+  QMutexLocker lLock(&mMutex);
+  if(!mWoken)
+    mCondition.wait(&mMutex, aTimeout);
+  mWoken = false;
+  return false;
+#endif
+}
+
+std::set<int>
+CommsWaiter::openSockets()
+{
+  std::set<int> lSockets;
+#ifndef WIN32
+  struct stat lStat;
+  long lMaxFd = sysconf(_SC_OPEN_MAX);
+
+  // Don't scan a silly number of descriptors if the limit is huge
+  if(lMaxFd < 0 || lMaxFd > 4096) lMaxFd = 4096;
+
+  for(int i = 0; i < lMaxFd; i++) {
+    if(fstat(i, &lStat) == 0 && S_ISSOCK(lStat.st_mode))
+      lSockets.insert(i);
+  }
+#endif
+  return lSockets;
+}
+
+void
+CommsWaiter::wakeup()
+{
+#ifndef WIN32
+  // A full pipe already guarantees a wakeup so ignore EAGAIN
+  char lByte = 1;
+  if(write(mPipe[1], &lByte, 1) < 0) {
+    REG_DBGMSG("CommsWaiter::wakeup: wakeup pipe full");
+  }
+#else
+  QMutexLocker lLock(&mMutex);
+  mWoken = true;
+  mCondition.wakeAll();
+#endif
+}
@@ -74,7 +74,8 @@
 #include "types.h"
 #include "debug.h"
 
-ConfigForm::ConfigForm(int aCurrentIntervalValue, QWidget *parent,
+ConfigForm::ConfigForm(int aCurrentIntervalValue, const QString &aWhat,
+		       QWidget *parent,
 		       const char *name,
 		       bool modal, Qt::WFlags f)
   : QDialog( parent, name, modal, f ),
@@ -98,7 +99,7 @@ ConfigForm::ConfigForm(int aCurrentIntervalValue, QWidget *parent,
   Q3VBoxLayout *lFormLayout = new Q3VBoxLayout(this, 10, 10, "configformlayout");
   Q3HBoxLayout *lButtonLayout = new Q3HBoxLayout(6, "configbuttonlayout");
 
-  lFormLayout->addWidget(new QLabel("Enter interval value (seconds) \n"
+  lFormLayout->addWidget(new QLabel("Enter " + aWhat + " value (seconds) \n"
 				    "Valid range: "
 				    +QString::number(mMinVal_Sec)
 				    +" - "+QString::number(mMaxVal_Sec)
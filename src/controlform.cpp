@@ -71,6 +71,7 @@
 #include <Q3HBoxLayout>
 #include <Q3VBoxLayout>
 #include <Q3HButtonGroup>
+#include <QTimer>
 
 #include "buildconfig.h"
 #include "types.h"
@@ -83,10 +84,15 @@
 #include "exception.h"
 #include "steerermainwindow.h"
 
+#include "regexecutor.h"
+#include "tracerecorder.h"
+
+#include <boost/bind.hpp>
+
 #include "ReG_Steer_Steerside.h"
 
 ControlForm::ControlForm(QWidget *aParent, const char *aName, int aSimHandle,
-			 Application *aApplication, QMutex *aMutex)
+			 Application *aApplication, ReGExecutor *aExecutor)
   : QWidget(aParent, aName), mSimHandle(aSimHandle),
     mEmitButton(kNULL),
     mSndSampleButton(kNULL), mSetSampleFreqButton(kNULL),
@@ -98,7 +104,7 @@ ControlForm::ControlForm(QWidget *aParent, const char *aName, int aSimHandle,
     mIOTypeChkPtTable(kNULL),
     mCloseButton(kNULL), mDetachButton(kNULL), mStopButton(kNULL),
     mPauseButton(kNULL), mConsumeDataButton(kNULL),
-    mEmitDataButton(kNULL), mMutexPtr(aMutex)
+    mEmitDataButton(kNULL), mExecutor(aExecutor), mRedrawPending(false)
 {
   REG_DBGCON("ControlForm");
 
@@ -176,7 +182,7 @@ ControlForm::ControlForm(QWidget *aParent, const char *aName, int aSimHandle,
   mMonTableLabel = new TableLabel("Monitored Parameters",
 				  this);
   mMonParamTable = new ParameterTable(this, "monparamtable",
-				      aSimHandle, mMutexPtr);
+				      aSimHandle, mExecutor);
   mMonParamTable->initTable();
 
   Q3VBoxLayout *lTopLeftLayout = new Q3VBoxLayout(-1, "topleftlayout");
@@ -187,7 +193,7 @@ ControlForm::ControlForm(QWidget *aParent, const char *aName, int aSimHandle,
   // table for steered parameters
   mSteerParamTable = new SteeredParameterTable(this,"steerparamtable",
 					       mMonParamTable, aSimHandle,
-					       mMutexPtr);
+					       mExecutor);
   mSteerParamTable->initTable();
   connect(mSteerParamTable, SIGNAL(detachFromApplicationForErrorSignal()),
 	  aApplication, SLOT(detachFromApplicationForErrorSlot()));
@@ -214,7 +220,7 @@ ControlForm::ControlForm(QWidget *aParent, const char *aName, int aSimHandle,
   //------------------------------
   // Table for IOTypes
   mIOTypeSampleTable = new IOTypeTable(this,"sampleparamtable",aSimHandle,
-				       mMutexPtr);
+				       mExecutor);
   mIOTypeSampleTable->initTable();
   connect(mIOTypeSampleTable, SIGNAL(detachFromApplicationForErrorSignal()),
 	  aApplication, SLOT(detachFromApplicationForErrorSlot()));
@@ -255,7 +261,7 @@ ControlForm::ControlForm(QWidget *aParent, const char *aName, int aSimHandle,
   //-------------------------------------------
   // table and buttons for checkpoint iotypes
   mIOTypeChkPtTable = new IOTypeTable(this,"chkptparamtable", aSimHandle,
-				      mMutexPtr, true);
+				      mExecutor, true);
   mIOTypeChkPtTable->initTable();
   connect(mIOTypeChkPtTable,
 	  SIGNAL(detachFromApplicationForErrorSignal()),
@@ -337,125 +343,117 @@ ControlForm::~ControlForm()
 }
 
 void
-ControlForm::updateParameters(const bool isStatusMsg)
+ControlForm::applyUpdate(const StatusUpdate &aUpdate)
 {
-  // update monitored parameters
-  updateParameters(false, isStatusMsg);
+  TraceScope lTrace("gui", "applyUpdate", mSimHandle);
+
+  // everything here was read from the library by the CommsThread so
+  // there is no need to go near the library mutex
+
+  if(aUpdate.mHaveParams && aUpdate.mHistoryOnly){
+    // we're behind so only add new parameters (so that their values
+    // can be logged) and leave showing the latest values until the
+    // next redraw
+    applyParameters(aUpdate.mMonParams, false, true);
+    applyParameters(aUpdate.mSteerParams, true, true);
+    mLatestMonParams = aUpdate.mMonParams;
+    mLatestSteerParams = aUpdate.mSteerParams;
+
+    if(!mRedrawPending){
+      mRedrawPending = true;
+      QTimer::singleShot(kHISTORY_ONLY_REDRAW, this, SLOT(redrawSlot()));
+    }
+  }
+  else if(aUpdate.mHaveParams){
+    // show the latest values but don't log them - they are all in the
+    // status records
+    applyParameters(aUpdate.mMonParams, false);
+    applyParameters(aUpdate.mSteerParams, true);
+    mRedrawPending = false;
+  }
+
+  if(aUpdate.mHaveIOTypes)
+    applyIOTypes(aUpdate.mIOTypes, false);
+  if(aUpdate.mHaveChkTypes)
+    applyIOTypes(aUpdate.mChkTypes, true);
 
-  // update steered parameters
-  updateParameters(true, isStatusMsg);
+  // one row of the history per status
+  HistoryTable *lHistory = mApplication->getHistoryTable();
+  for(unsigned int i=0; i<aUpdate.mRecords.size(); i++)
+    lHistory->append(aUpdate.mRecords[i]);
 
-  if(!mHistoryPlotList.isEmpty()){
+  if(!aUpdate.mRecords.empty() && !mHistoryPlotList.isEmpty() &&
+     !aUpdate.mHistoryOnly){
     // Emit a SIGNAL so that any HistoryPlots can update
     emit paramUpdateSignal();
   }
 }
 
-
 void
-ControlForm::updateParameters(const bool aSteeredFlag,
-			      const bool isStatusMsg)
+ControlForm::redrawSlot()
 {
-  // call ReG library routines to get all parameter data and
-  // update table displaying paremeters on gui
-  // aSteerFlag determines whether get monitored or steered parameters
+  // a normal update may have got in first
+  if(!mRedrawPending)
+    return;
+  mRedrawPending = false;
+  TraceScope lTrace("gui", "redraw", mSimHandle);
 
-  int lNumParams = 0;
-  bool lCleanUpFlag = false;
-  Param_details_struct *lParamDetails = kNULL;
+  applyParameters(mLatestMonParams, false);
+  applyParameters(mLatestSteerParams, true);
 
-  try
-    {
-      // find out number of parameters that library is going to give us
-      mMutexPtr->lock();
-      if(Get_param_number(mSimHandle, aSteeredFlag, &lNumParams)
-	 != REG_SUCCESS){  //ReG library
-	mMutexPtr->unlock();
-	THROWEXCEPTION("Get_param_number");
-      }
-      mMutexPtr->unlock();
-
-      if (lNumParams > 0)
-	{
-	  // flag that cleanup required - don't like this but checking
-	  // for kNULL didn't work
-	  lCleanUpFlag = true;
-
-	  // set up arrays of appropriate size for Get_param_values
-	  lParamDetails = new Param_details_struct[lNumParams];
-
-	  // point to relevent table - i.e. steered or monitored
-	  ParameterTable *lTablePtr;
-	  if (aSteeredFlag)
-	    lTablePtr = mSteerParamTable;
-	  else
-	    lTablePtr = mMonParamTable;
-
-	  // get parameter data from library and update tables on gui
-	  mMutexPtr->lock();
-	  if (Get_param_values(mSimHandle,		//ReG library
-			       aSteeredFlag,
-			       lNumParams,
-			       lParamDetails) == REG_SUCCESS){
-	    mMutexPtr->unlock();
-
-	    for (int i=0; i<lNumParams; i++){
-	      //check if already exists - if so only update value
-	      if (!(lTablePtr->updateRow(lParamDetails[i].handle,
-					 lParamDetails[i].value,
-					 isStatusMsg))){
-
-		// must be new parameter so add it
-		if (aSteeredFlag){
-		  ((SteeredParameterTable*)lTablePtr)->addRow(lParamDetails[i].handle,
-							      lParamDetails[i].label,
-							      lParamDetails[i].value,
-							      lParamDetails[i].type,
-							      lParamDetails[i].min_val,
-							      lParamDetails[i].max_val);
-		}
-		else{
-		  lTablePtr->addRow(lParamDetails[i].handle,
-				    lParamDetails[i].label,
-				    lParamDetails[i].value,
-				    lParamDetails[i].type);
-		}
-	      }
-	    } //for lNumParams
-
-	    // Adjust width of first column holding labels
-	    lTablePtr->adjustColumn(0);
-
-	  } // if Get_param_values
-	  else{
-
-	    mMutexPtr->unlock();
-	    THROWEXCEPTION("Get_param_values");
-	  }
-
-	  // delete local arrays
-	  delete [] lParamDetails;
-
-	} // if lNumParams > 0
-
-      // finally check for any parameters no longer present and flag
-      // as unregistered SMR XXX to do (ReG library not support unRegister yet)
-
-    } //try
+  if(!mHistoryPlotList.isEmpty())
+    emit paramUpdateSignal();
+}
 
-  catch (SteererException StEx)
-    {
-      // clean up
-      if (lCleanUpFlag)
-	{
-	  delete [] lParamDetails;
-	}
-
-      // rethrow to Application::processNextMessage
-      throw StEx;
+
+void
+ControlForm::applyParameters(const std::vector<ParamState> &aParams,
+			     const bool aSteeredFlag, const bool aNewOnly)
+{
+  // point to relevent table - i.e. steered or monitored
+  ParameterTable *lTablePtr;
+  bool lAdded = false;
+
+  if (aSteeredFlag)
+    lTablePtr = mSteerParamTable;
+  else
+    lTablePtr = mMonParamTable;
+
+  for (unsigned int i=0; i<aParams.size(); i++){
+    if (aNewOnly && lTablePtr->findParameter(aParams[i].mHandle))
+      continue;
+
+    //check if already exists - if so only update value
+    if (!(lTablePtr->updateRow(aParams[i].mHandle, aParams[i].mParsed))){
+
+      // must be new parameter so add it
+      if (aSteeredFlag){
+	((SteeredParameterTable*)lTablePtr)->addRow(aParams[i].mHandle,
+						    aParams[i].mLabel.latin1(),
+						    aParams[i].mParsed,
+						    aParams[i].mType,
+						    aParams[i].mMinVal.latin1(),
+						    aParams[i].mMaxVal.latin1());
+      }
+      else{
+	lTablePtr->addRow(aParams[i].mHandle,
+			  aParams[i].mLabel.latin1(),
+			  aParams[i].mParsed,
+			  aParams[i].mType);
+      }
+      lAdded = true;
     }
+  }
+
+  // Adjust width of first column holding labels - only new labels
+  // can change it
+  if(lAdded)
+    lTablePtr->adjustColumn(0);
 
-} // ::updateParameters
+  // finally check for any parameters no longer present and flag
+  // as unregistered SMR XXX to do (ReG library not support unRegister yet)
+
+} // ::applyParameters
 
 //--------------------------------------------------------------------
 
@@ -467,23 +465,28 @@ ControlForm::updateParameterLog()
 }
 
 //--------------------------------------------------------------------
+void
+ControlForm::getHistoryTimelines(HistoryCache::SeriesMap &aSeries)
+{
+  mMonParamTable->getHistoryTimelines(aSeries);
+  mSteerParamTable->getHistoryTimelines(aSeries);
+}
 
+//--------------------------------------------------------------------
 void
-ControlForm::updateIOTypes(bool aChkPtType)
+ControlForm::useCachedHistories()
 {
-  // call ReG library routines to get all iotype data
-  // and update tables displaying iotypes on gui
+  mMonParamTable->useCachedHistories();
+  mSteerParamTable->useCachedHistories();
+}
 
-  IOTypeTable	*lIOTypeTablePtr;
-  int		lNumTypes;
-  int		*lHandles = kNULL;
-  int		*lTypes = kNULL;
-  int		*lVals = kNULL;
-  char		**lLabels = kNULL;
-  bool		lCleanUpFlag = false;
-  int		lStatus = REG_FAILURE;
-  int		i;
+//--------------------------------------------------------------------
 
+void
+ControlForm::applyIOTypes(const std::vector<IOTypeState> &aTypes,
+			  const bool aChkPtType)
+{
+  IOTypeTable	*lIOTypeTablePtr;
 
   // point to relevant table - sample or checkpoint
   if (aChkPtType)
@@ -491,111 +494,24 @@ ControlForm::updateIOTypes(bool aChkPtType)
   else
     lIOTypeTablePtr = mIOTypeSampleTable;
 
+  REG_DBGMSG1("Number IO/Chk Types: Monitored = ", aTypes.size());
 
-  try
+  for (unsigned int i=0; i<aTypes.size(); i++)
   {
-
-    mMutexPtr->lock();
-    if (aChkPtType){
-      lStatus = Get_chktype_number(mSimHandle, &lNumTypes);	//ReG library
-    }
-    else{
-      lStatus = Get_iotype_number(mSimHandle, &lNumTypes);	//ReG library
-    }
-    mMutexPtr->unlock();
-
-    if(lStatus != REG_SUCCESS)
-      THROWEXCEPTION("Get_iotype_number");
-
-    REG_DBGMSG1("Number IO/Chk Types: Monitored = ", lNumTypes);
-
-    if (lNumTypes>0)
+    //check if already exists - if so only update frequency value
+    if (!(lIOTypeTablePtr->updateRow(aTypes[i].mHandle,
+				     aTypes[i].mFrequency)))
     {
-      lCleanUpFlag = true;
-
-      // setup arrays of appropriate size for Get_param_values
-      // note that REG_MAX_STRING_LENGTH is max string length imposed by library
-      lHandles = new int[lNumTypes];
-      lTypes = new int[lNumTypes];
-      lVals = new int[lNumTypes];
-      lLabels = new char *[lNumTypes];
-      for(i=0; i<lNumTypes; i++)
-      {
-	lLabels[i] = new char[REG_MAX_STRING_LENGTH + 1];
-      }
-
-      mMutexPtr->lock();
-      if (aChkPtType){
-	lStatus = Get_chktypes(mSimHandle,     		//ReG library
-			       lNumTypes,
-			       lHandles,
-			       lLabels,
-			       lTypes,
-			       lVals);
-      }
-      else{
-	lStatus = Get_iotypes(mSimHandle,      		//ReG library
-			      lNumTypes,
-			      lHandles,
-			      lLabels,
-			      lTypes,
-			      lVals);
-      }
-      mMutexPtr->unlock();
-
-      if (lStatus == REG_SUCCESS)
-      {
-	for (i=0; i<lNumTypes; i++)
-	{
-	  //check if already exists - if so only update frequency value
-	  if (!(lIOTypeTablePtr->updateRow(lHandles[i], lVals[i])))
-	  {
-	    // new IOTypee so add it
-	    lIOTypeTablePtr->addRow(lHandles[i], lLabels[i], lVals[i], lTypes[i]);
-	  }
-
-	} //for lNumTypes
-      } // if Get_IOType_values
-      else
-	THROWEXCEPTION("Get_iotypes");
-
-      // note: no need to check for any IOType no longer present
-      // as iotype cannot be unregistered
-
-      // delete local arrays
-      delete [] lHandles;
-      delete [] lTypes;
-      delete [] lVals;
-      for(i=0; i<lNumTypes; i++)
-	{
-	  delete [] lLabels[i];
-	}
-      delete [] lLabels;
-
-    } //if (lNumTypes>0)
-
-  } //try
-
-  catch (SteererException StEx)
-  {
-    if (lCleanUpFlag)
-    {
-      delete [] lHandles;
-      delete [] lTypes;
-      delete [] lVals;
-      for(int i=0; i<lNumTypes; i++)
-	{
-	  delete [] lLabels[i];
-	}
-      delete [] lLabels;
+      // new IOTypee so add it
+      lIOTypeTablePtr->addRow(aTypes[i].mHandle, aTypes[i].mLabel.latin1(),
+			      aTypes[i].mFrequency, aTypes[i].mType);
     }
-
-    // rethrow to Application::processNextMessage
-    throw StEx;
   }
 
+  // note: no need to check for any IOType no longer present
+  // as iotype cannot be unregistered
 
-} // ::updateIOTypes
+} // ::applyIOTypes
 
 
 void
@@ -775,12 +691,9 @@ ControlForm::emitAllValuesSlot()
     if (lCount > 0)
     {
       // call ReG library function to "emit" values to steered application
-      mMutexPtr->lock();
-      lReGStatus = Emit_control(mSimHandle,		//ReG library
-				0,
-				NULL,
-				NULL);
-      mMutexPtr->unlock();
+      lReGStatus = mExecutor->callFromGui(REG_CALL_SITE("Emit_control"),		//ReG library
+					  boost::bind(Emit_control, mSimHandle, 0,
+						      (int*)NULL, (char**)NULL));
 
       if (lReGStatus != REG_SUCCESS)
 	THROWEXCEPTION("Emit_contol");
@@ -909,7 +822,7 @@ void ControlForm::newHistoryPlot(Parameter *xParamPtr, Parameter *yParamPtr,
 			     xLabel.latin1(),
 			     yLabel.latin1(),
 			     xParamPtr->getId(), yParamPtr->getId(),
-			     this->application()->name());
+			     this->application()->name(), mSimHandle);
   mHistoryPlotList.append(lQwtPlot);
   lQwtPlot->show();
 
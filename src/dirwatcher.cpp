@@ -0,0 +1,178 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file dirwatcher.cpp
+    @brief Implementation of the DirWatcher class
+    @author Robert Haines */
+
+#include "buildconfig.h"
+#include "dirwatcher.h"
+#include "debug.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+
+// Filesystem magic numbers (see statfs(2)) on which inotify only
+// reports changes made by this host.
+static const long kNETWORK_FS_MAGIC[] = {
+  0x6969,               // NFS
+  0x517B,               // SMB
+  0xFF534D42,           // CIFS
+  0x0BD00BD0,           // Lustre
+  0x47504653            // GPFS
+};
+
+static bool
+isNetworkFilesystem(const char *aPath)
+{
+  struct statfs lStat;
+
+  if(statfs(aPath, &lStat) != 0)
+    return false;
+
+  for(unsigned int i = 0; i < sizeof(kNETWORK_FS_MAGIC)/sizeof(long); i++) {
+    if((long) lStat.f_type == kNETWORK_FS_MAGIC[i])
+      return true;
+  }
+  return false;
+}
+#endif
+
+DirWatcher::DirWatcher()
+  : mFd(-1)
+{
+}
+
+DirWatcher::~DirWatcher()
+{
+#ifdef __linux__
+  if(mFd >= 0) close(mFd);
+#endif
+}
+
+int
+DirWatcher::descriptor() const
+{
+  return mWatches.empty() ? -1 : mFd;
+}
+
+int
+DirWatcher::addDirectory(const QString &aDir)
+{
+#ifdef __linux__
+  if(aDir.isEmpty())
+    return -1;
+
+  if(isNetworkFilesystem(aDir.latin1())) {
+    REG_DBGMSG1("DirWatcher: not watching network filesystem ",
+		aDir.latin1());
+    return -1;
+  }
+
+  if(mFd < 0) {
+    mFd = inotify_init();
+    if(mFd < 0) {
+      REG_DBGMSG1("DirWatcher: inotify_init failed, errno = ", errno);
+      return -1;
+    }
+    fcntl(mFd, F_SETFL, fcntl(mFd, F_GETFL) | O_NONBLOCK);
+  }
+
+  // The application signals a new message by creating files in the
+  // directory so that is all we need to hear about.
+  int lWatch = inotify_add_watch(mFd, aDir.latin1(),
+				 IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO);
+  if(lWatch < 0) {
+    REG_DBGMSG1("DirWatcher: cannot watch ", aDir.latin1());
+    return -1;
+  }
+
+  // inotify hands back the same identifier for the same directory
+  mWatches[lWatch]++;
+  return lWatch;
+#else
+  return -1;
+#endif
+}
+
+void
+DirWatcher::removeDirectory(const int aWatch)
+{
+  std::map<int, int>::iterator lIt = mWatches.find(aWatch);
+
+  if(lIt == mWatches.end())
+    return;
+
+  if(--(lIt->second) > 0)
+    return;
+
+#ifdef __linux__
+  inotify_rm_watch(mFd, aWatch);
+#endif
+  mWatches.erase(lIt);
+}
+
+bool
+DirWatcher::drain()
+{
+  bool lGotEvents = false;
+#ifdef __linux__
+  if(mFd < 0)
+    return false;
+
+  // Big enough for plenty of events with their file names
+  char lBuf[4096];
+  while(read(mFd, lBuf, sizeof(lBuf)) > 0)
+    lGotEvents = true;
+#endif
+  return lGotEvents;
+}
@@ -0,0 +1,294 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+/** @file historycache.cpp
+    @brief Implementation of the HistoryCache class
+    @author Robert Haines */
+
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QEvent>
+#include <QFile>
+#include <algorithm>
+#include <stdio.h>
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+#include "historycache.h"
+#include "seriescodec.h"
+#include "typedseries.h"
+#include "debug.h"
+
+// "ReGH", followed by the version of the layout of the file
+static const quint32 kMAGIC = 0x52654748;
+static const quint32 kVERSION = 2;
+// How each history's values are stored
+static const quint8 kDOUBLES = 0;
+static const quint8 kINTEGERS = 1;
+// Values are compressed in blocks the size of a segment
+static const int kBLOCK_SIZE = SeriesStore::kSEGMENT_SIZE;
+// No compressed block comes near this, so anything bigger is corrupt
+static const quint32 kMAX_BLOCK_BYTES = 2 * kBLOCK_SIZE * sizeof(double);
+
+// Read one history's values, written by writeValues()
+template <typename T>
+static bool
+readValues(QDataStream &aStream, std::vector<T> &aValues)
+{
+  qint32 lCount;
+  aStream >> lCount;
+  if(aStream.status() != QDataStream::Ok || lCount < 0)
+    return false;
+
+  // Grow a block at a time rather than trusting the count, so that
+  // a corrupt one runs out of file long before it runs out of memory
+  aValues.clear();
+  std::vector<char> lBlock;
+  for(int lDone = 0; lDone < lCount; lDone += kBLOCK_SIZE){
+    const int lNum = std::min(lCount - lDone, kBLOCK_SIZE);
+    quint32 lBytes;
+    aStream >> lBytes;
+    if(aStream.status() != QDataStream::Ok || lBytes == 0 ||
+       lBytes > kMAX_BLOCK_BYTES)
+      return false;
+
+    lBlock.resize(lBytes);
+    if(aStream.readRawData(&lBlock[0], lBytes) != (int) lBytes)
+      return false;
+    aValues.resize(lDone + lNum);
+    if(!SeriesCodec::decode(&lBlock[0], lBytes, &aValues[lDone], lNum))
+      return false;
+  }
+
+  return true;
+}
+
+// Write one history's values
+template <typename T>
+static void
+writeValues(QDataStream &aStream, const std::vector<T> &aValues)
+{
+  const int lCount = aValues.size();
+  aStream << (qint32) lCount;
+
+  std::vector<char> lBlock;
+  for(int lDone = 0; lDone < lCount; lDone += kBLOCK_SIZE){
+    lBlock.clear();
+    SeriesCodec::encode(&aValues[lDone], std::min(lCount - lDone, kBLOCK_SIZE),
+			lBlock);
+    aStream << (quint32) lBlock.size();
+    aStream.writeRawData(&lBlock[0], lBlock.size());
+  }
+}
+
+HistoryCache::HistoryCache(const QString &aDir, const QString &aKey)
+  : mKey(aKey)
+{
+  // keys are addresses or directories, so only keep what is safe in a
+  // file name - the key itself is checked on loading, so two that end
+  // up the same only share a file
+  QString lName = aKey;
+  for(int i = 0; i < (int) lName.length(); i++){
+    const QChar lChar = lName.at(i);
+    if(!lChar.isLetterOrNumber() && lChar != '-' && lChar != '.')
+      lName[i] = '_';
+  }
+  mFileName = QDir(aDir).filePath(QString("steerer-history-%1").arg(lName));
+}
+
+bool
+HistoryCache::load()
+{
+  mSeries.clear();
+
+  QFile lFile(mFileName);
+  if(!lFile.open(QIODevice::ReadOnly))
+    return false;
+
+  QDataStream lStream(&lFile);
+  lStream.setVersion(QDataStream::Qt_4_0);
+
+  quint32 lMagic, lVersion, lNumSeries;
+  QString lKey;
+  lStream >> lMagic >> lVersion;
+  if(lStream.status() != QDataStream::Ok || lMagic != kMAGIC ||
+     lVersion != kVERSION){
+    REG_DBGMSG1("HistoryCache: not a history cache: ", mFileName.ascii());
+    return false;
+  }
+  lStream >> lKey >> lNumSeries;
+  if(lStream.status() != QDataStream::Ok || lKey != mKey){
+    REG_DBGMSG1("HistoryCache: cache is for another application: ",
+		mFileName.ascii());
+    return false;
+  }
+
+  for(quint32 i = 0; i < lNumSeries; i++){
+    QString lLabel;
+    quint8  lType;
+    lStream >> lLabel >> lType;
+
+    Series &lSeries = mSeries[lLabel];
+    lSeries.mIsInteger = lType == kINTEGERS;
+    if(lStream.status() != QDataStream::Ok ||
+       (lType != kDOUBLES && lType != kINTEGERS) ||
+       !(lSeries.mIsInteger ? readValues(lStream, lSeries.mIntegers) :
+	 readValues(lStream, lSeries.mValues))){
+      REG_DBGMSG1("HistoryCache: ignoring corrupt cache ",
+		  mFileName.ascii());
+      mSeries.clear();
+      return false;
+    }
+  }
+
+  REG_DBGMSG1("HistoryCache: loaded histories from ", mFileName.ascii());
+  return true;
+}
+
+bool
+HistoryCache::take(const QString &aLabel, std::vector<double> &aValues)
+{
+  SeriesMap::iterator lIter = mSeries.find(aLabel);
+  if(lIter == mSeries.end())
+    return false;
+
+  Series &lSeries = lIter->second;
+  if(lSeries.mIsInteger){
+    aValues.resize(lSeries.mIntegers.size());
+    for(unsigned int i = 0; i < aValues.size(); i++)
+      aValues[i] = SeriesTraits<int64_t>::toDouble(lSeries.mIntegers[i]);
+  }
+  else
+    aValues.swap(lSeries.mValues);
+
+  mSeries.erase(lIter);
+  return true;
+}
+
+void
+HistoryCache::clear()
+{
+  mSeries.clear();
+}
+
+bool
+HistoryCache::save(const SeriesMap &aSeries) const
+{
+  // write the new file alongside so the old one is only replaced by a
+  // whole one
+  const QString lNewName = mFileName + ".new";
+  QFile lFile(lNewName);
+  if(!lFile.open(QIODevice::WriteOnly)){
+    REG_DBGMSG1("HistoryCache: can't open ", lNewName.ascii());
+    return false;
+  }
+
+  QDataStream lStream(&lFile);
+  lStream.setVersion(QDataStream::Qt_4_0);
+  lStream << kMAGIC << kVERSION << mKey << (quint32) aSeries.size();
+
+  SeriesMap::const_iterator lIter;
+  for(lIter = aSeries.begin(); lIter != aSeries.end(); ++lIter){
+    const Series &lSeries = lIter->second;
+    lStream << lIter->first << (lSeries.mIsInteger ? kINTEGERS : kDOUBLES);
+    if(lSeries.mIsInteger)
+      writeValues(lStream, lSeries.mIntegers);
+    else
+      writeValues(lStream, lSeries.mValues);
+  }
+
+  // make sure it is all on disk before it replaces the old one
+  lFile.flush();
+#ifndef WIN32
+  fsync(lFile.handle());
+#endif
+  lFile.close();
+  if(lFile.error() != QFile::NoError){
+    REG_DBGMSG1("HistoryCache: couldn't write ", lNewName.ascii());
+    QFile::remove(lNewName);
+    return false;
+  }
+
+  // rename() replaces the old file in one go, except on Windows where
+  // it won't replace one at all
+#ifdef WIN32
+  QFile::remove(mFileName);
+#endif
+  if(rename(QFile::encodeName(lNewName).data(),
+	    QFile::encodeName(mFileName).data()) != 0){
+    REG_DBGMSG1("HistoryCache: couldn't replace ", mFileName.ascii());
+    QFile::remove(lNewName);
+    return false;
+  }
+
+  REG_DBGMSG1("HistoryCache: saved histories to ", mFileName.ascii());
+  return true;
+}
+
+QString
+HistoryCache::getFileName() const
+{
+  return mFileName;
+}
+
+HistoryCacheLoader::HistoryCacheLoader(HistoryCache *aCache,
+				       QObject *aReceiver,
+				       const int aEventType)
+  : mCache(aCache), mReceiver(aReceiver), mEventType(aEventType)
+{
+}
+
+void
+HistoryCacheLoader::run()
+{
+  mCache->load();
+  QCoreApplication::postEvent(mReceiver,
+			      new QEvent((QEvent::Type) mEventType));
+}
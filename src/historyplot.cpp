@@ -75,17 +75,31 @@
 #include "historyplot.h"
 #include "parameterhistory.h"
 #include "debug.h"
+#include "tracerecorder.h"
 
 using namespace std;
 
+/// A value in a row of the table as text for the data export.
+/// Integers are written exactly, anything else in aFormat to
+/// aPrecision.
+static QString exportText(const ParameterHistory &aHist, const int aRow,
+			  const char aFormat, const int aPrecision)
+{
+  int64_t lValue;
+  if(aHist.holdsIntegers() && aHist.int64AtRow(aRow, lValue))
+    return QString::number((qlonglong) lValue);
+  return QString::number(aHist.valueAtRow(aRow), aFormat, aPrecision);
+}
+
 HistoryPlot::HistoryPlot(ParameterHistory *_mXParamHist,
 			 ParameterHistory *_mYParamHist,
 			 const char *_lLabelx,
 			 const char *_lLabely,
 			 const int _xparamID,
 			 const int _yparamID,
-			 const char *_lComponentName)
-  : Q3Frame(0,0,0), mXParamHist(_mXParamHist)
+			 const char *_lComponentName,
+			 const int aSimHandle)
+  : Q3Frame(0,0,0), mXParamHist(_mXParamHist), mSimHandle(aSimHandle)
 {
   // Local copies of passed parameters
   xparamID = _xparamID;
@@ -181,7 +195,6 @@ HistoryPlot::HistoryPlot(ParameterHistory *_mXParamHist,
   mAutoXAxisSet = true;
   mUseLogXAxis = false;
   mUseLogYAxis = false;
-  mForceHistRedraw = false;
   // Default to displaying symbols
   mDisplaySymbolsSet = true;
   // Default to displaying a curve too
@@ -312,52 +325,33 @@ void HistoryPlot::fileDataSave(){
     }
     ts << endl;
 
-    // Work out how many points we've got of 'historical data' - compare
-    // the no. available for each ordinate and use the smaller of the two.
-    plot = mSubPlotList.first();
-    int lNumPts = plot->mYParamHist->mPreviousHistArraySize;
-    plot = mSubPlotList.next();
-    while(plot){
-      if(lNumPts > plot->mYParamHist->mPreviousHistArraySize){
-	lNumPts = plot->mYParamHist->mPreviousHistArraySize;
-      }
-      plot = mSubPlotList.next();
-    }
-    if(mXParamHist->mPreviousHistArraySize < lNumPts){
-      lNumPts = mXParamHist->mPreviousHistArraySize;
-    }
-    double *lX = mXParamHist->mPtrPreviousHistArray;
-
-    // The 'historical' data itself
-    for(i=0; i<lNumPts; i++){
-      ts << lX[i] ;
-      for ( plot = mSubPlotList.first(); plot; plot = mSubPlotList.next() ){
-	ts << QString("  %1").arg((plot->mYParamHist->mPtrPreviousHistArray)[i],
-				  0, 'e', 8);
-      }
-      ts << endl;
-    }
-
-    // Now do the data we've collected whilst we've been attached
-    plot = mSubPlotList.first();
-    lNumPts = plot->mYParamHist->mArrayPos;
-    plot = mSubPlotList.next();
-    while(plot){
-      if(lNumPts > plot->mYParamHist->mArrayPos){
-	lNumPts = plot->mYParamHist->mArrayPos;
+    // One line for each row of the application's history that has
+    // the abscissa in it: first those from the log of before we
+    // attached, then those we've collected whilst we've been attached.
+    // Values that weren't logged in a row come out as nan. Rows whose
+    // values have been dropped to save memory can't be exported.
+    const int lNumLog = mXParamHist->getNumLogValues();
+    const int lFirstRow = mXParamHist->getFirstRow();
+    const int lFirstKept = mXParamHist->getValues().getFirstKept();
+    const int lNumRows = lNumLog + mXParamHist->getNumValues();
+    for(i=0; i<lNumRows; i++){
+      if(i == lNumLog && lFirstKept > 0){
+	ts << "# " << lFirstKept << " older values not kept" << endl;
+	i += lFirstKept;
       }
-      plot = mSubPlotList.next();
-    }
-    if(mXParamHist->mArrayPos < lNumPts){
-      lNumPts = mXParamHist->mArrayPos;
-    }
-    lX = mXParamHist->ptrToArray();
 
-    // The data itself
-    for(i=0; i<lNumPts; i++){
-      ts << lX[i];
+      const bool lLog = i < lNumLog;
+      const int lRow = lFirstRow + i - lNumLog;
+      if(lLog)
+	ts << mXParamHist->logValueAt(i);
+      else
+	ts << exportText(*mXParamHist, lRow, 'g', 6);
       for ( plot = mSubPlotList.first(); plot; plot = mSubPlotList.next() ){
-	ts << QString("  %1").arg((plot->mYParamHist->ptrToArray())[i], 0, 'e', 8);
+	if(lLog)
+	  ts << QString("  %1").arg(plot->mYParamHist->logValueAt(i),
+				    0, 'e', 8);
+	else
+	  ts << "  " << exportText(*plot->mYParamHist, lRow, 'e', 8);
       }
       ts << endl;
     }
@@ -378,7 +372,7 @@ void HistoryPlot::doPlot(){
 
   HistorySubPlot *plot;
   for ( plot = mSubPlotList.first(); plot; plot = mSubPlotList.next() ){
-    plot->doPlot(mForceHistRedraw);
+    plot->doPlot();
   }
 
   // allow the user to define the Y axis dims if desired
@@ -422,7 +416,6 @@ void HistoryPlot::addPlot(ParameterHistory *_mYParamHist,
   ++mColourIter;
 
   // redraw the plot
-  mForceHistRedraw = true;
   doPlot();
 }
 
@@ -436,7 +429,6 @@ void HistoryPlot::autoYAxisSlot(){
   mGraphMenu->setItemChecked(mAutoYAxisId, mAutoYAxisSet);
   mGraphMenu->setItemEnabled(mYLowerBoundId, !mAutoYAxisSet);
   mGraphMenu->setItemEnabled(mYUpperBoundId, !mAutoYAxisSet);
-  mForceHistRedraw = true;
   // redraw the plot
   doPlot();
 }
@@ -451,7 +443,6 @@ void HistoryPlot::autoXAxisSlot(){
   mGraphMenu->setItemChecked(mAutoXAxisId, mAutoXAxisSet);
   mGraphMenu->setItemEnabled(mXLowerBoundId, !mAutoXAxisSet);
   mGraphMenu->setItemEnabled(mXUpperBoundId, !mAutoXAxisSet);
-  mForceHistRedraw = true;
   // redraw the plot
   doPlot();
 }
@@ -484,7 +475,6 @@ void HistoryPlot::graphYUpperBoundSlot(){
   else{
     mYUpperBound = upperBoundTmp;
   }
-  mForceHistRedraw = true;
   // redraw the plot
   doPlot();
 }
@@ -514,7 +504,6 @@ void HistoryPlot::graphXUpperBoundSlot(){
   else{
     mXUpperBound = upperBoundTmp;
   }
-  mForceHistRedraw = true;
   // redraw the plot
   doPlot();
 }
@@ -544,7 +533,6 @@ void HistoryPlot::graphYLowerBoundSlot(){
   else{
     mYLowerBound = lowerBoundTmp;
   }
-  mForceHistRedraw = true;
   // redraw the plot
   doPlot();
 }
@@ -574,7 +562,6 @@ void HistoryPlot::graphXLowerBoundSlot(){
   else{
     mXLowerBound = lowerBoundTmp;
   }
-  mForceHistRedraw = true;
   // redraw the plot
   doPlot();
 }
@@ -586,7 +573,6 @@ void HistoryPlot::graphDisplaySymbolsSlot(){
 
   mDisplaySymbolsSet = !mDisplaySymbolsSet;
   mGraphMenu->setItemChecked(mShowSymbolsId, mDisplaySymbolsSet);
-  mForceHistRedraw = true;
   // redraw the plot
   doPlot();
 }
@@ -604,7 +590,6 @@ void HistoryPlot::graphDisplayCurvesSlot(){
     plot->graphDisplayCurves();
   }
 
-  mForceHistRedraw = true;
   // redraw the plot
   doPlot();
 }
@@ -627,7 +612,6 @@ void HistoryPlot::toggleLogAxisXSlot(){
 
   //mPlotter->changeAxisOptions(mPlotter->xBottom,
   //			      QwtAutoScale::Logarithmic, mUseLogXAxis);
-  mForceHistRedraw = true;
   // redraw the plot
   doPlot();
 }
@@ -650,7 +634,6 @@ void HistoryPlot::toggleLogAxisYSlot(){
 
   //mPlotter->changeAxisOptions(mPlotter->yLeft,
   //			      QwtAutoScale::Logarithmic, mUseLogYAxis);
-  mForceHistRedraw = true;
   // redraw the plot
   doPlot();
 }
@@ -659,6 +642,7 @@ void HistoryPlot::toggleLogAxisYSlot(){
 /** Update the graph with new data
  */
 void HistoryPlot::updateSlot(){
+  TraceScope lTrace("gui", "replot", mSimHandle);
   HistorySubPlot *plot;
   for ( plot = mSubPlotList.first(); plot; plot = mSubPlotList.next() ){
     plot->update();
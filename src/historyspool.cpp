@@ -0,0 +1,196 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file historyspool.cpp
+    @brief Implementation of the HistorySpool class
+    @author Robert Haines */
+
+#include <QDir>
+#include <QFile>
+
+#include "buildconfig.h"
+#include "historyspool.h"
+#include "seriesstore.h"
+#include "debug.h"
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+// The biggest raw block holds one segment of doubles
+static const size_t kBLOCK_BYTES = SeriesStore::kSEGMENT_SIZE * sizeof(double);
+// The file is grown and mapped this many of them at a time
+static const int kEXTENT_BLOCKS = 1024;
+static const size_t kEXTENT_BYTES = kEXTENT_BLOCKS * kBLOCK_BYTES;
+// Keep every block aligned for reading doubles from
+static const size_t kBLOCK_ALIGN = sizeof(double);
+
+HistorySpool::HistorySpool(const QString &aDir, const int aSimHandle,
+			   const int aHotValues, const bool aCompress)
+  : mFile(-1), mCompress(aCompress), mUsed(0)
+{
+  // always keep the segment being added to
+  mHotSegments = (aHotValues + SeriesStore::kSEGMENT_SIZE - 1) /
+    SeriesStore::kSEGMENT_SIZE;
+  if(mHotSegments < 1)
+    mHotSegments = 1;
+
+#ifndef WIN32
+  QString lTemplate = QDir(aDir).filePath(QString("steerer-%1-XXXXXX")
+					  .arg(aSimHandle));
+  QByteArray lName = QFile::encodeName(lTemplate);
+
+  mFile = mkstemp(lName.data());
+  if(mFile < 0){
+    REG_DBGMSG1("HistorySpool: couldn't create a spool file in ",
+		aDir.ascii());
+    return;
+  }
+
+  // nobody else needs to find it
+  unlink(lName.data());
+  REG_DBGMSG1("HistorySpool: spooling history to ", lName.data());
+#else
+  REG_DBGMSG("HistorySpool: spooling history to file not supported");
+#endif
+}
+
+HistorySpool::~HistorySpool()
+{
+#ifndef WIN32
+  for(unsigned int i = 0; i < mExtents.size(); i++)
+    munmap(mExtents[i], kEXTENT_BYTES);
+  if(mFile >= 0)
+    close(mFile);
+#endif
+}
+
+bool
+HistorySpool::isOpen() const
+{
+  return mFile >= 0;
+}
+
+bool
+HistorySpool::isCompressing() const
+{
+  return mCompress;
+}
+
+int
+HistorySpool::getHotSegments() const
+{
+  return mHotSegments;
+}
+
+const char *
+HistorySpool::write(const char *aData, const size_t aBytes)
+{
+#ifndef WIN32
+  if(mFile < 0 || aBytes > kEXTENT_BYTES)
+    return NULL;
+
+  // a block never straddles two extents so it is all in one map
+  qint64 lOffset = (mUsed + kBLOCK_ALIGN - 1) & ~(qint64) (kBLOCK_ALIGN - 1);
+  if(lOffset % kEXTENT_BYTES + aBytes > kEXTENT_BYTES)
+    lOffset = (lOffset / kEXTENT_BYTES + 1) * kEXTENT_BYTES;
+
+  const char *lExtent = mapExtent(lOffset / kEXTENT_BYTES);
+  if(!lExtent)
+    return NULL;
+
+  size_t lDone = 0;
+  while(lDone < aBytes){
+    const ssize_t lWritten = pwrite(mFile, aData + lDone, aBytes - lDone,
+				    (off_t) (lOffset + lDone));
+    if(lWritten <= 0){
+      REG_DBGMSG("HistorySpool: write to spool file failed");
+      return NULL;
+    }
+    lDone += lWritten;
+  }
+
+  mUsed = lOffset + aBytes;
+  return lExtent + lOffset % kEXTENT_BYTES;
+#else
+  return NULL;
+#endif
+}
+
+const char *
+HistorySpool::mapExtent(const unsigned int aExtent)
+{
+#ifndef WIN32
+  // extents are only ever used in order
+  if(aExtent == mExtents.size()){
+    // grow the file to cover the whole extent (sparsely) so that all
+    // of the map is backed by it
+    const off_t lEnd = (off_t) (aExtent + 1) * kEXTENT_BYTES;
+    if(ftruncate(mFile, lEnd) != 0){
+      REG_DBGMSG("HistorySpool: couldn't grow spool file");
+      return NULL;
+    }
+
+    void *lMap = mmap(NULL, kEXTENT_BYTES, PROT_READ, MAP_SHARED, mFile,
+		      (off_t) aExtent * kEXTENT_BYTES);
+    if(lMap == MAP_FAILED){
+      REG_DBGMSG("HistorySpool: couldn't map spool file");
+      return NULL;
+    }
+    mExtents.push_back((char *) lMap);
+  }
+
+  return mExtents[aExtent];
+#else
+  return NULL;
+#endif
+}
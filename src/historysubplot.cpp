@@ -52,12 +52,145 @@
 #include <qwt_plot.h>
 #include <qwt_plot_curve.h>
 
+#include <algorithm>
+
 #include "buildconfig.h"
 #include "historysubplot.h"
 #include "historyplot.h"
 
 using namespace std;
 
+//---------------------------------------------------------------------------
+SeriesData::SeriesData(const SeriesStore *aX, const int aXStart,
+		       const SeriesStore *aY, const int aYStart,
+		       const size_t aSize)
+  : mXHist(NULL), mYHist(NULL), mNumLog(0),
+    mX(aX), mXStart(aXStart), mY(aY), mYStart(aYStart), mSize(aSize)
+{
+}
+
+//---------------------------------------------------------------------------
+SeriesData SeriesData::aligned(const ParameterHistory *aX,
+			       const ParameterHistory *aY)
+{
+  // Values from the same application line up by their row in its
+  // HistoryTable; otherwise all we can do is pair them off in order
+  const bool lSameTable = aX->getTable() == aY->getTable();
+  int lXFirst = 0;
+  int lYFirst = 0;
+  if(lSameTable){
+    lXFirst = aX->getFirstRow();
+    lYFirst = aY->getFirstRow();
+  }
+
+  const int lStart = std::max(lXFirst, lYFirst);
+  const int lFirst = std::max(lXFirst + aX->getValues().getFirstKept(),
+			      lYFirst + aY->getValues().getFirstKept());
+  const int lEnd = std::min(lXFirst + aX->getNumValues(),
+			    lYFirst + aY->getNumValues());
+
+  SeriesData lData(&aX->getValues(), lFirst - lXFirst,
+		   &aY->getValues(), lFirst - lYFirst,
+		   lEnd > lFirst ? lEnd - lFirst : 0);
+
+  if(lSameTable){
+    lData.mXHist = aX;
+    lData.mYHist = aY;
+    lData.mNumLog = std::min(aX->getNumLogValues(), aY->getNumLogValues());
+  }
+
+  // Anything before that has been dropped
+  if(lSameTable && lStart < lFirst && aX->getTiers() && aY->getTiers())
+    lData.addSummaries(*aX->getTiers(), *aY->getTiers(), lStart, lFirst);
+
+  return lData;
+}
+
+//---------------------------------------------------------------------------
+void SeriesData::addSummaries(const HistoryTiers &aX, const HistoryTiers &aY,
+			      const int aFrom, const int aTo)
+{
+  int lRow = aFrom;
+  while(lRow < aTo){
+    // The coarser tiers keep more, so the finest that both have
+    const int lXTier = aX.getFinestTier(lRow);
+    const int lYTier = aY.getFinestTier(lRow);
+    if(lXTier < 0 || lYTier < 0)
+      break;
+
+    const int lTier = std::max(lXTier, lYTier);
+    const int lBucket = lRow / HistoryTiers::getBucketRows(lTier);
+    const HistoryTiers::Bucket &lX = aX.getBucket(lTier, lBucket);
+    const HistoryTiers::Bucket &lY = aY.getBucket(lTier, lBucket);
+
+    if(lX.mCount > 0 && lY.mCount > 0){
+      mSummaryX.push_back(lX.getMean());
+      mSummaryY.push_back(lY.mMin);
+      mSummaryX.push_back(lX.getMean());
+      mSummaryY.push_back(lY.mMax);
+    }
+
+    lRow = (lBucket + 1) * HistoryTiers::getBucketRows(lTier);
+  }
+}
+
+//---------------------------------------------------------------------------
+QwtData *SeriesData::copy() const
+{
+  return new SeriesData(*this);
+}
+
+//---------------------------------------------------------------------------
+size_t SeriesData::size() const
+{
+  return mNumLog + mSummaryX.size() + mSize;
+}
+
+//---------------------------------------------------------------------------
+double SeriesData::x(size_t i) const
+{
+  if(i < (size_t) mNumLog)
+    return mXHist->logValueAt(i);
+  i -= mNumLog;
+  if(i < mSummaryX.size())
+    return mSummaryX[i];
+  return mX->at(mXStart + i - mSummaryX.size());
+}
+
+//---------------------------------------------------------------------------
+double SeriesData::y(size_t i) const
+{
+  if(i < (size_t) mNumLog)
+    return mYHist->logValueAt(i);
+  i -= mNumLog;
+  if(i < mSummaryY.size())
+    return mSummaryY[i];
+  return mY->at(mYStart + i - mSummaryY.size());
+}
+
+//---------------------------------------------------------------------------
+QwtDoubleRect SeriesData::boundingRect() const
+{
+  if(!mXHist || size() == 0)
+    return QwtData::boundingRect();
+
+  HistoryTiers::Bucket lX = mXHist->getSummary(mXStart, mXStart + mSize);
+  HistoryTiers::Bucket lY = mYHist->getSummary(mYStart, mYStart + mSize);
+  for(unsigned int i = 0; i < mSummaryX.size(); i++){
+    lX.add(mSummaryX[i]);
+    lY.add(mSummaryY[i]);
+  }
+  if(mNumLog > 0){
+    lX.add(mXHist->getLogSummary());
+    lY.add(mYHist->getLogSummary());
+  }
+
+  if(lX.mCount == 0 || lY.mCount == 0)
+    return QwtData::boundingRect();
+  return QwtDoubleRect(lX.mMin, lY.mMin,
+		       lX.mMax - lX.mMin, lY.mMax - lY.mMin);
+}
+
 //---------------------------------------------------------------------------
 HistorySubPlot::HistorySubPlot(HistoryPlot *lHistPlot,
 			       QwtPlot *lPlotter,
@@ -71,8 +204,6 @@ HistorySubPlot::HistorySubPlot(HistoryPlot *lHistPlot,
     mYParamHist(lYParamHist),  mYparamID(yparamID)
 {
   mCurve           = new QwtPlotCurve(mLabely);
-  mHistCurve       = new QwtPlotCurve(mLabely);
-  mPreviousLogSize = 0;
   //cout << "ARPDBG: HistorySubPlot: colour = " << mColour << endl;
 }
 
@@ -82,14 +213,10 @@ HistorySubPlot::~HistorySubPlot()
 }
 
 //---------------------------------------------------------------------------
-void HistorySubPlot::doPlot(bool lForceHistRedraw=false)
+void HistorySubPlot::doPlot()
 {
   QwtSymbol lPlotSymbol;
   int ltmp = 0;
-  bool lReplotHistory = lForceHistRedraw ||
-    (mYParamHist->mPreviousHistArraySize != mPreviousLogSize);
-
-  mPreviousLogSize = mYParamHist->mPreviousHistArraySize;
 
   // Insert new curves if any
   if(mCurve->plot() == NULL) {
@@ -109,23 +236,10 @@ void HistorySubPlot::doPlot(bool lForceHistRedraw=false)
 //     this->graphDisplayCurves();
 //   }
 
-  if(mHistCurve->plot() == NULL && mYParamHist->mPreviousHistArraySize > 0) {
-    mHistCurve->attach(mPlotter);
-    this->graphDisplayCurves();
-  }
-
-//   if(mHistCurveID == CURVE_UNSET &&
-//      mYParamHist->mPreviousHistArraySize > 0){
-//     mHistCurveID = mPlotter->insertCurve(mLabely);
-//     this->graphDisplayCurves();
-//   }
-
-  // Work out how many points we've got - compare the no. available
-  // for each ordinate and use the smaller of the two.
-  int nPoints = mYParamHist->mArrayPos +  mYParamHist->mPreviousHistArraySize;
-  if((mXParamHist->mArrayPos + mXParamHist->mPreviousHistArraySize) < nPoints){
-    nPoints = mXParamHist->mArrayPos + mXParamHist->mPreviousHistArraySize;
-  }
+  // Shallow copy of data for plot - it reads the values where they
+  // are logged so this stays valid until the next update
+  SeriesData lData = SeriesData::aligned(mXParamHist, mYParamHist);
+  int nPoints = lData.size();
 
   // Add symbols - scale their size appropriately.  This code only
   // takes account of the TOTAL no. of points to be plotted and the
@@ -151,41 +265,21 @@ void HistorySubPlot::doPlot(bool lForceHistRedraw=false)
       lPlotSymbol.setSize(ltmp);
       lPlotSymbol.setStyle(QwtSymbol::Diamond);
       mCurve->setSymbol(lPlotSymbol);
-      mHistCurve->setSymbol(lPlotSymbol);
     }
   }
   if(ltmp <= 0){
       lPlotSymbol.setStyle(QwtSymbol::NoSymbol);
       mCurve->setSymbol(lPlotSymbol);
-      mHistCurve->setSymbol(lPlotSymbol);
   }
 
-  nPoints = mYParamHist->mArrayPos;
-  if(mXParamHist->mArrayPos < nPoints){
-    nPoints = mXParamHist->mArrayPos;
-  }
-
-  // Shallow copy of data for plot
-  mCurve->setRawData(mXParamHist->ptrToArray(),
-		     mYParamHist->ptrToArray(), nPoints);
-
-  if(lReplotHistory) {
-    nPoints = mYParamHist->mPreviousHistArraySize;
-    if(mXParamHist->mPreviousHistArraySize < nPoints) {
-      nPoints = mXParamHist->mPreviousHistArraySize;
-    }
-    if(nPoints) {
-      mHistCurve->setRawData(mXParamHist->mPtrPreviousHistArray,
-			     mYParamHist->mPtrPreviousHistArray, nPoints);
-    }
-  }
+  mCurve->setData(lData);
 }
 
 //---------------------------------------------------------------------------
 void HistorySubPlot::update()
 {
   // redo the plot
-  doPlot(true);
+  doPlot();
 }
 
 //---------------------------------------------------------------------------
@@ -235,15 +329,9 @@ void HistorySubPlot::graphDisplayCurves()
   if(mHistPlot->mDisplayCurvesSet){
     mCurve->setStyle(QwtPlotCurve::Lines);
     mCurve->setPen(QPen(mColour));
-    if(mHistCurve->plot() != NULL){
-      mHistCurve->setStyle(QwtPlotCurve::Lines);
-      mHistCurve->setPen(QPen(mColour));
-    }
   }
   else{
     mCurve->setStyle(QwtPlotCurve::NoCurve);
-    if(mHistCurve->plot() != NULL)
-      mHistCurve->setStyle(QwtPlotCurve::NoCurve);
   }
 }
 
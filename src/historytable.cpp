@@ -0,0 +1,578 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file historytable.cpp
+    @brief Implementation of the HistoryTable class
+    @author Robert Haines */
+
+#include <algorithm>
+#include <limits>
+
+#include "types.h"
+#include "historytable.h"
+
+#include "ReG_Steer_Steerside.h"
+
+static const double kNO_VALUE = std::numeric_limits<double>::quiet_NaN();
+
+HistoryTable::HistoryTable()
+  : mRetainedRows(0), mFirstSeqNum(0), mSeqNumHandle(-1),
+    mLogsBySeqNum(false), mNumLogRows(0)
+{
+}
+
+HistoryTable::~HistoryTable()
+{
+  std::map<int, Column *>::iterator lIter;
+  for(lIter = mColumns.begin(); lIter != mColumns.end(); ++lIter)
+    delete lIter->second;
+}
+
+void
+HistoryTable::setSpool(const boost::shared_ptr<HistorySpool> &aSpool)
+{
+  mSpool = aSpool;
+  mSeqNums.setSpool(aSpool);
+
+  std::map<int, Column *>::iterator lIter;
+  for(lIter = mColumns.begin(); lIter != mColumns.end(); ++lIter)
+    lIter->second->mValues->setSpool(aSpool);
+}
+
+void
+HistoryTable::setRetainedRows(const int aRows)
+{
+  mRetainedRows = aRows;
+}
+
+void
+HistoryTable::append(const StatusRecord &aRecord)
+{
+  const int lRow = mSeqNums.size();
+
+  for(unsigned int i = 0; i < aRecord.mHandles.size(); i++){
+    const ParamValue &lValue = aRecord.mValues[i];
+    Column *&lColumn = mColumns[aRecord.mHandles[i]];
+    if(!lColumn){
+      lColumn = new Column(lRow, lValue.getType());
+      lColumn->mValues->setSpool(mSpool);
+      if(mRetainedRows > 0)
+	lColumn->mTiers.setRetained(kHISTORY_TIER_BUCKETS);
+    }
+
+    // only the first of any repeats counts
+    if(lColumn->mFirstRow + lColumn->mValues->size() == lRow){
+      // integers go in as they are so that they stay exact
+      if(lValue.getType() == REG_INT)
+	lColumn->mValues->appendInt64(lValue.toInt64());
+      else
+	lColumn->mValues->append(lValue.toDouble());
+      lColumn->mTiers.append(lRow, lValue.toDouble());
+    }
+  }
+
+  // fill the gaps left by parameters this status didn't have
+  std::map<int, Column *>::iterator lIter;
+  for(lIter = mColumns.begin(); lIter != mColumns.end(); ++lIter){
+    Column *lColumn = lIter->second;
+    if(lColumn->mFirstRow + lColumn->mValues->size() == lRow)
+      lColumn->mValues->append(kNO_VALUE);
+  }
+
+  mSeqNums.appendValue(aRecord.mSeqNum);
+  if(lRow == 0){
+    mFirstSeqNum = aRecord.mSeqNum;
+    spliceLogs();
+  }
+
+  // values are only freed a segment at a time so there's no point
+  // trying more often than that
+  const int lDrop = lRow + 1 - mRetainedRows;
+  if(mRetainedRows > 0 && lDrop > 0 &&
+     (lDrop & (SeriesStore::kSEGMENT_SIZE - 1)) == 0)
+    release(lDrop);
+}
+
+void
+HistoryTable::release(const int aRow)
+{
+  mSeqNums.release(aRow);
+
+  std::map<int, Column *>::iterator lIter;
+  for(lIter = mColumns.begin(); lIter != mColumns.end(); ++lIter){
+    Column *lColumn = lIter->second;
+    if(aRow > lColumn->mFirstRow)
+      lColumn->mValues->release(aRow - lColumn->mFirstRow);
+  }
+}
+
+int
+HistoryTable::getNumRows() const
+{
+  return mSeqNums.size();
+}
+
+const SeriesStore &
+HistoryTable::getSeqNums() const
+{
+  return mSeqNums;
+}
+
+std::vector<int>
+HistoryTable::getHandles() const
+{
+  std::vector<int> lHandles;
+  std::map<int, Column *>::const_iterator lIter;
+  for(lIter = mColumns.begin(); lIter != mColumns.end(); ++lIter)
+    lHandles.push_back(lIter->first);
+  return lHandles;
+}
+
+const SeriesStore *
+HistoryTable::getColumn(const int aHandle) const
+{
+  std::map<int, Column *>::const_iterator lIter = mColumns.find(aHandle);
+  return lIter == mColumns.end() ? NULL : lIter->second->mValues;
+}
+
+int
+HistoryTable::getFirstRow(const int aHandle) const
+{
+  std::map<int, Column *>::const_iterator lIter = mColumns.find(aHandle);
+  return lIter == mColumns.end() ? getNumRows() : lIter->second->mFirstRow;
+}
+
+int
+HistoryTable::getFirstKeptRow(const int aHandle) const
+{
+  std::map<int, Column *>::const_iterator lIter = mColumns.find(aHandle);
+  if(lIter == mColumns.end())
+    return getNumRows();
+  return lIter->second->mFirstRow + lIter->second->mValues->getFirstKept();
+}
+
+const HistoryTiers *
+HistoryTable::getTiers(const int aHandle) const
+{
+  std::map<int, Column *>::const_iterator lIter = mColumns.find(aHandle);
+  return lIter == mColumns.end() ? NULL : &lIter->second->mTiers;
+}
+
+double
+HistoryTable::getValue(const int aHandle, const int aRow) const
+{
+  std::map<int, Column *>::const_iterator lIter = mColumns.find(aHandle);
+  if(lIter == mColumns.end() || aRow >= getNumRows() ||
+     aRow < lIter->second->mFirstRow + lIter->second->mValues->getFirstKept())
+    return kNO_VALUE;
+  return lIter->second->mValues->at(aRow - lIter->second->mFirstRow);
+}
+
+bool
+HistoryTable::getInt64Value(const int aHandle, const int aRow,
+			    int64_t &aValue) const
+{
+  std::map<int, Column *>::const_iterator lIter = mColumns.find(aHandle);
+  if(lIter == mColumns.end() || aRow >= getNumRows() ||
+     aRow < lIter->second->mFirstRow + lIter->second->mValues->getFirstKept())
+    return false;
+
+  aValue = lIter->second->mValues->atInt64(aRow - lIter->second->mFirstRow);
+  return aValue != SeriesTraits<int64_t>::noValue();
+}
+
+bool
+HistoryTable::holdsIntegers(const int aHandle) const
+{
+  const SeriesStore *lColumn = getColumn(aHandle);
+  return lColumn && lColumn->holdsIntegers();
+}
+
+void
+HistoryTable::getRow(const int aRow, std::vector<double> &aValues) const
+{
+  aValues.clear();
+  aValues.reserve(mColumns.size());
+
+  std::map<int, Column *>::const_iterator lIter;
+  for(lIter = mColumns.begin(); lIter != mColumns.end(); ++lIter){
+    const Column *lColumn = lIter->second;
+    const int lIndex = aRow - lColumn->mFirstRow;
+    aValues.push_back(lIndex < lColumn->mValues->getFirstKept() ? kNO_VALUE :
+		      lColumn->mValues->at(lIndex));
+  }
+}
+
+HistoryTiers::Bucket
+HistoryTable::getSummary(const int aHandle,
+			 const int aFrom,
+			 const int aTo) const
+{
+  std::map<int, Column *>::const_iterator lIter = mColumns.find(aHandle);
+  if(lIter == mColumns.end())
+    return HistoryTiers::Bucket();
+
+  const Column *lColumn = lIter->second;
+  return lColumn->mTiers.summarise(*lColumn->mValues, lColumn->mFirstRow,
+				   aFrom, aTo);
+}
+
+int
+HistoryTable::findRow(const int aSeqNum) const
+{
+  int lLow = mSeqNums.getFirstKept();
+  int lHigh = mSeqNums.size();
+
+  while(lLow < lHigh){
+    const int lMid = lLow + (lHigh - lLow) / 2;
+    if(mSeqNums.valueAt(lMid) < aSeqNum)
+      lLow = lMid + 1;
+    else
+      lHigh = lMid;
+  }
+
+  return lLow;
+}
+
+void
+HistoryTable::setLog(const int aHandle, const double *aValues,
+		     const int aSize)
+{
+  Log &lLog = mLogs[kFETCHED_LOG][aHandle];
+  lLog.mValues = aValues;
+  lLog.mSize = aValues ? aSize : 0;
+  updateLog(aHandle, kFETCHED_LOG);
+}
+
+void
+HistoryTable::setCachedLog(const int aHandle,
+			   std::vector<double> &aValues)
+{
+  Log &lLog = mLogs[kCACHED_LOG][aHandle];
+  lLog.mOwned.swap(aValues);
+  aValues.clear();
+  lLog.mValues = lLog.mOwned.empty() ? NULL : &lLog.mOwned[0];
+  lLog.mSize = lLog.mOwned.size();
+  updateLog(aHandle, kCACHED_LOG);
+}
+
+void
+HistoryTable::updateLog(const int aHandle, const LogSource aSource)
+{
+  // The log rows only depend on the sequence numbers, unless the logs
+  // are being used as they are
+  if(aHandle == mSeqNumHandle || !mLogsBySeqNum){
+    spliceLogs();
+    return;
+  }
+
+  summariseLog(aHandle);
+  if(aSource == kFETCHED_LOG)
+    dropCachedLog(aHandle);
+}
+
+void
+HistoryTable::setSeqNumHandle(const int aHandle)
+{
+  mSeqNumHandle = aHandle;
+  spliceLogs();
+}
+
+bool
+HistoryTable::hasLog(const int aHandle) const
+{
+  for(int i = 0; i < kNUM_LOG_SOURCES; i++){
+    const Log *lLog = findLog(i, aHandle);
+    if(lLog && lLog->mSize > 0)
+      return true;
+  }
+  return false;
+}
+
+int
+HistoryTable::getNumLogRows() const
+{
+  return mNumLogRows;
+}
+
+double
+HistoryTable::getLogValue(const int aHandle, const int aLogRow) const
+{
+  for(int i = 0; i < kNUM_LOG_SOURCES; i++){
+    const Log *lLog = findLog(i, aHandle);
+    const int lIndex = mLogRows[i].empty() ? -1 : mLogRows[i][aLogRow];
+    if(lLog && lIndex >= 0 && lIndex < lLog->mSize)
+      return lLog->mValues[lIndex];
+  }
+  return kNO_VALUE;
+}
+
+HistoryTiers::Bucket
+HistoryTable::getLogSummary(const int aHandle) const
+{
+  std::map<int, HistoryTiers::Bucket>::const_iterator lIter =
+    mLogSummaries.find(aHandle);
+  return lIter == mLogSummaries.end() ? HistoryTiers::Bucket() :
+    lIter->second;
+}
+
+void
+HistoryTable::getTimeline(const int aHandle,
+			  std::vector<double> &aValues) const
+{
+  std::vector<int> lRuns;
+  getDroppedRuns(lRuns);
+
+  // rows are dropped from every column at once
+  const int lFirstKept = mSeqNums.getFirstKept();
+  aValues.clear();
+  aValues.reserve(getNumLogRows() + lRuns.size() + getNumRows() - lFirstKept);
+  for(int i = 0; i < getNumLogRows(); i++)
+    aValues.push_back(getLogValue(aHandle, i));
+  for(unsigned int i = 0; i < lRuns.size(); i++)
+    aValues.push_back(getSummary(aHandle, i > 0 ? lRuns[i - 1] : 0,
+				 lRuns[i]).mLast);
+  for(int i = lFirstKept; i < getNumRows(); i++)
+    aValues.push_back(getValue(aHandle, i));
+}
+
+void
+HistoryTable::getTimeline(const int aHandle,
+			  std::vector<int64_t> &aValues) const
+{
+  typedef SeriesTraits<int64_t> Traits;
+  std::vector<int> lRuns;
+  getDroppedRuns(lRuns);
+
+  // the logs and the summaries are doubles however they started out
+  const int lFirstKept = mSeqNums.getFirstKept();
+  aValues.clear();
+  aValues.reserve(getNumLogRows() + lRuns.size() + getNumRows() - lFirstKept);
+  for(int i = 0; i < getNumLogRows(); i++)
+    aValues.push_back(Traits::fromDouble(getLogValue(aHandle, i)));
+  for(unsigned int i = 0; i < lRuns.size(); i++)
+    aValues.push_back(Traits::fromDouble(getSummary(aHandle,
+						    i > 0 ? lRuns[i - 1] : 0,
+						    lRuns[i]).mLast));
+  for(int i = lFirstKept; i < getNumRows(); i++){
+    int64_t lValue;
+    aValues.push_back(getInt64Value(aHandle, i, lValue) ? lValue :
+		      Traits::noValue());
+  }
+}
+
+void
+HistoryTable::getDroppedRuns(std::vector<int> &aEnds) const
+{
+  aEnds.clear();
+
+  // Stand in for the dropped rows with the last values of each bucket
+  // that covers them. All of the columns use the same buckets, so the
+  // values in each of these rows are from the same status.
+  const int lFirstKept = mSeqNums.getFirstKept();
+  int lRow = 0;
+  while(lRow < lFirstKept){
+    const int lRows = HistoryTiers::getBucketRows(getTimelineTier(lRow));
+    const int lEnd = (lRow / lRows + 1) * lRows;
+    if(lEnd > lFirstKept)
+      break;
+    aEnds.push_back(lEnd);
+    lRow = lEnd;
+  }
+}
+
+int
+HistoryTable::getTimelineTier(const int aRow) const
+{
+  int lTier = 0;
+  std::map<int, Column *>::const_iterator lIter;
+  for(lIter = mColumns.begin(); lIter != mColumns.end(); ++lIter){
+    if(lIter->second->mFirstRow > aRow)
+      continue;
+    const int lFinest = lIter->second->mTiers.getFinestTier(aRow);
+    if(lFinest > lTier)
+      lTier = lFinest;
+  }
+  return lTier;
+}
+
+void
+HistoryTable::spliceLogs()
+{
+  mNumLogRows = 0;
+  for(int i = 0; i < kNUM_LOG_SOURCES; i++)
+    mLogRows[i].clear();
+
+  mLogsBySeqNum = hasLog(mSeqNumHandle);
+  if(mLogsBySeqNum){
+    // Every sequence number in any of the SEQUENCE_NUM logs is a log
+    // row. A source without one can't be lined up so isn't used.
+    std::vector<std::pair<double, int> > lSeqNums[kNUM_LOG_SOURCES];
+    std::vector<double> lRowSeqNums;
+    for(int i = 0; i < kNUM_LOG_SOURCES; i++){
+      getLogSeqNums(i, lSeqNums[i]);
+      for(unsigned int j = 0; j < lSeqNums[i].size(); j++)
+	lRowSeqNums.push_back(lSeqNums[i][j].first);
+    }
+    std::sort(lRowSeqNums.begin(), lRowSeqNums.end());
+    lRowSeqNums.erase(std::unique(lRowSeqNums.begin(), lRowSeqNums.end()),
+		      lRowSeqNums.end());
+    mNumLogRows = lRowSeqNums.size();
+
+    // both are in order, so each source's are found in one pass
+    for(int i = 0; i < kNUM_LOG_SOURCES; i++){
+      if(lSeqNums[i].empty())
+	continue;
+      mLogRows[i].assign(mNumLogRows, -1);
+      int lRow = 0;
+      for(unsigned int j = 0; j < lSeqNums[i].size(); j++){
+	while(lRowSeqNums[lRow] < lSeqNums[i][j].first)
+	  lRow++;
+	mLogRows[i][lRow] = lSeqNums[i][j].second;
+      }
+    }
+  }
+  else{
+    // no way of lining them up, so use one source's as they are
+    int lSource = kCACHED_LOG;
+    std::map<int, Log>::const_iterator lIter;
+    for(lIter = mLogs[kFETCHED_LOG].begin();
+	lIter != mLogs[kFETCHED_LOG].end(); ++lIter)
+      if(lIter->second.mSize > 0)
+	lSource = kFETCHED_LOG;
+
+    for(lIter = mLogs[lSource].begin(); lIter != mLogs[lSource].end(); ++lIter)
+      if(lIter->second.mSize > mNumLogRows)
+	mNumLogRows = lIter->second.mSize;
+    for(int i = 0; i < mNumLogRows; i++)
+      mLogRows[lSource].push_back(i);
+  }
+
+  // Free the cached logs that the fetched ones have replaced. The
+  // cached SEQUENCE_NUM log lines up the others, so it goes last.
+  mLogSummaries.clear();
+  std::vector<int> lHandles;
+  for(int i = 0; i < kNUM_LOG_SOURCES; i++){
+    std::map<int, Log>::const_iterator lIter;
+    for(lIter = mLogs[i].begin(); lIter != mLogs[i].end(); ++lIter)
+      lHandles.push_back(lIter->first);
+  }
+  std::sort(lHandles.begin(), lHandles.end());
+  lHandles.erase(std::unique(lHandles.begin(), lHandles.end()),
+		 lHandles.end());
+  for(unsigned int i = 0; i < lHandles.size(); i++){
+    summariseLog(lHandles[i]);
+    if(lHandles[i] != mSeqNumHandle)
+      dropCachedLog(lHandles[i]);
+  }
+  dropCachedLog(mSeqNumHandle);
+}
+
+void
+HistoryTable::getLogSeqNums(const int aSource,
+			    std::vector<std::pair<double, int> > &aSeqNums)
+  const
+{
+  aSeqNums.clear();
+  const Log *lLog = findLog(aSource, mSeqNumHandle);
+  if(!lLog)
+    return;
+
+  // only what came before the first status, once each
+  for(int i = 0; i < lLog->mSize; i++){
+    const double lSeqNum = lLog->mValues[i];
+    if(getNumRows() > 0 && lSeqNum >= mFirstSeqNum)
+      break;
+    if(lSeqNum != lSeqNum ||
+       (!aSeqNums.empty() && lSeqNum <= aSeqNums.back().first))
+      continue;
+    aSeqNums.push_back(std::make_pair(lSeqNum, i));
+  }
+}
+
+const HistoryTable::Log *
+HistoryTable::findLog(const int aSource,
+		      const int aHandle) const
+{
+  std::map<int, Log>::const_iterator lIter = mLogs[aSource].find(aHandle);
+  return lIter == mLogs[aSource].end() ? NULL : &lIter->second;
+}
+
+void
+HistoryTable::summariseLog(const int aHandle)
+{
+  HistoryTiers::Bucket &lSummary = mLogSummaries[aHandle];
+  lSummary = HistoryTiers::Bucket();
+  for(int i = 0; i < mNumLogRows; i++)
+    lSummary.add(getLogValue(aHandle, i));
+}
+
+void
+HistoryTable::dropCachedLog(const int aHandle)
+{
+  std::map<int, Log>::iterator lCached = mLogs[kCACHED_LOG].find(aHandle);
+  if(lCached == mLogs[kCACHED_LOG].end())
+    return;
+
+  // the cached SEQUENCE_NUM log lines up all of the others
+  if(aHandle == mSeqNumHandle && mLogs[kCACHED_LOG].size() > 1)
+    return;
+
+  const Log *lFetched = findLog(kFETCHED_LOG, aHandle);
+  const std::vector<int> &lCachedRows = mLogRows[kCACHED_LOG];
+  const std::vector<int> &lFetchedRows = mLogRows[kFETCHED_LOG];
+  for(unsigned int i = 0; i < lCachedRows.size(); i++){
+    if(lCachedRows[i] < 0 || lCachedRows[i] >= lCached->second.mSize)
+      continue;
+    if(!lFetched || lFetchedRows.empty() || lFetchedRows[i] < 0 ||
+       lFetchedRows[i] >= lFetched->mSize)
+      return;
+  }
+
+  mLogs[kCACHED_LOG].erase(lCached);
+}
@@ -0,0 +1,237 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file historytiers.cpp
+    @brief Implementation of the HistoryTiers class
+    @author Robert Haines */
+
+#include <limits>
+
+#include "historytiers.h"
+#include "seriesstore.h"
+
+static const double kNO_VALUE = std::numeric_limits<double>::quiet_NaN();
+
+HistoryTiers::Bucket::Bucket()
+  : mMin(kNO_VALUE), mMax(kNO_VALUE), mSum(0.0), mLast(kNO_VALUE),
+    mCount(0)
+{
+}
+
+void
+HistoryTiers::Bucket::add(const double aValue)
+{
+  if(aValue != aValue)
+    return;
+
+  if(mCount == 0){
+    mMin = aValue;
+    mMax = aValue;
+  }
+  else{
+    if(aValue < mMin)
+      mMin = aValue;
+    if(aValue > mMax)
+      mMax = aValue;
+  }
+  mSum += aValue;
+  mLast = aValue;
+  mCount++;
+}
+
+void
+HistoryTiers::Bucket::add(const Bucket &aOther)
+{
+  if(aOther.mCount == 0)
+    return;
+
+  if(mCount == 0){
+    mMin = aOther.mMin;
+    mMax = aOther.mMax;
+  }
+  else{
+    if(aOther.mMin < mMin)
+      mMin = aOther.mMin;
+    if(aOther.mMax > mMax)
+      mMax = aOther.mMax;
+  }
+  mSum += aOther.mSum;
+  mLast = aOther.mLast;
+  mCount += aOther.mCount;
+}
+
+double
+HistoryTiers::Bucket::getMean() const
+{
+  return mCount > 0 ? mSum / mCount : kNO_VALUE;
+}
+
+HistoryTiers::HistoryTiers()
+  : mRetained(0)
+{
+}
+
+void
+HistoryTiers::setRetained(const int aBuckets)
+{
+  mRetained = aBuckets;
+}
+
+void
+HistoryTiers::append(const int aRow, const double aValue)
+{
+  for(int i = 0; i < kNUM_TIERS; i++){
+    Tier &lTier = mTiers[i];
+    const int lBucket = aRow >> (kTIER_BITS * (i + 1));
+
+    if(lTier.mBuckets.empty())
+      lTier.mFirst = lBucket;
+    // a column only skips rows before its first value
+    while(lTier.mFirst + (int) lTier.mBuckets.size() <= lBucket)
+      lTier.mBuckets.push_back(Bucket());
+    lTier.mBuckets.back().add(aValue);
+
+    if(mRetained > 0 && i < kNUM_TIERS - 1 &&
+       (int) lTier.mBuckets.size() > mRetained){
+      lTier.mBuckets.pop_front();
+      lTier.mFirst++;
+    }
+  }
+}
+
+void
+HistoryTiers::clear()
+{
+  for(int i = 0; i < kNUM_TIERS; i++){
+    mTiers[i].mFirst = 0;
+    mTiers[i].mBuckets.clear();
+  }
+}
+
+int
+HistoryTiers::getBucketRows(const int aTier)
+{
+  return 1 << (kTIER_BITS * (aTier + 1));
+}
+
+int
+HistoryTiers::getFirstBucket(const int aTier) const
+{
+  return mTiers[aTier].mFirst;
+}
+
+int
+HistoryTiers::getEndBucket(const int aTier) const
+{
+  return mTiers[aTier].mFirst + mTiers[aTier].mBuckets.size();
+}
+
+const HistoryTiers::Bucket &
+HistoryTiers::getBucket(const int aTier,
+			const int aBucket) const
+{
+  return mTiers[aTier].mBuckets[aBucket - mTiers[aTier].mFirst];
+}
+
+int
+HistoryTiers::getFinestTier(const int aRow) const
+{
+  for(int i = 0; i < kNUM_TIERS; i++){
+    const int lBucket = aRow >> (kTIER_BITS * (i + 1));
+    if(lBucket >= getFirstBucket(i) && lBucket < getEndBucket(i))
+      return i;
+  }
+  return -1;
+}
+
+HistoryTiers::Bucket
+HistoryTiers::summarise(const SeriesStore &aValues,
+			const int aFirstRow,
+			const int aFrom,
+			const int aTo) const
+{
+  const int lFirstKept = aFirstRow + aValues.getFirstKept();
+  const int lEnd = aFirstRow + aValues.size() < aTo ?
+    aFirstRow + aValues.size() : aTo;
+  Bucket lSummary;
+
+  // Take the biggest whole bucket that starts at each row, so the
+  // values are only read one at a time up to the first bucket
+  // boundary and from the last one
+  int lRow = aFrom > aFirstRow ? aFrom : aFirstRow;
+  while(lRow < lEnd){
+    int lTier = kNUM_TIERS - 1;
+    for(; lTier >= 0; lTier--){
+      const int lRows = getBucketRows(lTier);
+      const int lBucket = lRow / lRows;
+      if(lRow % lRows == 0 && lRow + lRows <= lEnd &&
+	 lBucket >= getFirstBucket(lTier) && lBucket < getEndBucket(lTier))
+	break;
+    }
+
+    if(lTier >= 0){
+      lSummary.add(getBucket(lTier, lRow / getBucketRows(lTier)));
+      lRow += getBucketRows(lTier);
+    }
+    else if(lRow >= lFirstKept){
+      lSummary.add(aValues.at(lRow - aFirstRow));
+      lRow++;
+    }
+    else{
+      // dropped, so all there is is the bucket it's in
+      lTier = getFinestTier(lRow);
+      if(lTier < 0)
+	break;
+      const int lBucket = lRow / getBucketRows(lTier);
+      lSummary.add(getBucket(lTier, lBucket));
+      lRow = (lBucket + 1) * getBucketRows(lTier);
+    }
+  }
+
+  return lSummary;
+}
@@ -65,12 +65,15 @@
 #include "chkptform.h"
 #include "exception.h"
 #include "iotypetable.h"
+#include "regexecutor.h"
+
+#include <boost/bind.hpp>
 
 IOTypeTable::IOTypeTable(QWidget *aParent, const char *aName, int aSimHandle,
-			 QMutex *aMutex, bool aChkPtType)
+			 ReGExecutor *aExecutor, bool aChkPtType)
   : Table(aParent, aName, aSimHandle), mChkPtTypeFlag(aChkPtType),
     mRestartRowIndex(kNULL_INDX), mRestartRowIndexNew(kNULL_INDX),
-    mMutexPtr(aMutex)
+    mExecutor(aExecutor)
 {
   REG_DBGCON("IOTypeTable constructor");
 
@@ -229,8 +232,12 @@ IOTypeTable::updateRow(const int lHandle, const int lVal)
   if ((lIOTypePtr = findIOType(lHandle)) != kNULL)
   {
     int lRowIndex = lIOTypePtr->getRowIndex();
-    item(lRowIndex,kIO_VALUE_COLUMN)->setText(QString::number(lVal));
-    updateCell(lRowIndex, kIO_VALUE_COLUMN);
+    QString lText = QString::number(lVal);
+    // Only redraw the cell if the frequency has actually changed
+    if(item(lRowIndex,kIO_VALUE_COLUMN)->text() != lText){
+      item(lRowIndex,kIO_VALUE_COLUMN)->setText(lText);
+      updateCell(lRowIndex, kIO_VALUE_COLUMN);
+    }
     return true;
   }
 
@@ -490,21 +497,18 @@ IOTypeTable::setNewFreqValuesInLib()
 
       int lReGStatus = REG_FAILURE;
 
-      mMutexPtr->lock();
-
       if (mChkPtTypeFlag){
-	lReGStatus = Set_chktype_freq(getSimHandle(), //ReG library
-				     lIndex,
-				     lHandles,
-				     lFreqs);
+	lReGStatus = mExecutor->call(REG_CALL_SITE("Set_chktype_freq"), //ReG library
+				     boost::bind(Set_chktype_freq,
+						 getSimHandle(), lIndex,
+						 lHandles, lFreqs));
       }
       else{
-	lReGStatus = Set_iotype_freq(getSimHandle(),  //ReG library
-				     lIndex,
-				     lHandles,
-				     lFreqs);
+	lReGStatus = mExecutor->call(REG_CALL_SITE("Set_iotype_freq"),  //ReG library
+				     boost::bind(Set_iotype_freq,
+						 getSimHandle(), lIndex,
+						 lHandles, lFreqs));
       }
-      mMutexPtr->unlock();
 
       // set the values in the steering library
       if (lReGStatus != REG_SUCCESS)
@@ -552,13 +556,10 @@ IOTypeTable::emitValuesSlot()
 
     if (setNewFreqValuesInLib() > 0)
     {
-      mMutexPtr->lock();
       // "emit" values to steered application
-      lReGStatus = Emit_control(getSimHandle(),	       	//ReG library
-				0,
-				NULL,
-				NULL);
-      mMutexPtr->unlock();
+      lReGStatus = mExecutor->callFromGui(REG_CALL_SITE("Emit_control"),	       	//ReG library
+					  boost::bind(Emit_control, getSimHandle(),
+						      0, (int*)NULL, (char**)NULL));
 
       if (lReGStatus != REG_SUCCESS)
 	THROWEXCEPTION("Emit_contol");
@@ -774,7 +775,10 @@ void IOTypeTable::createButtonPressedSlot(){
 
       // library call to emit application
       if (lNumAdded >0){
-        if (Emit_control(getSimHandle(), lNumAdded, lCommandArray, lCmdParamArray) != REG_SUCCESS){
+        if (mExecutor->callFromGui(REG_CALL_SITE("Emit_control"),
+				   boost::bind(Emit_control, getSimHandle(),
+					       lNumAdded, lCommandArray,
+					       lCmdParamArray)) != REG_SUCCESS){
           THROWEXCEPTION("Emit_control");
         }
       }
@@ -836,16 +840,15 @@ void IOTypeTable::restartButtonPressedSlot(){
 
           // Get number log entries for this checkpoint
           int lNumEntries = 0;
-          mMutexPtr->lock();
-          if (Get_chk_log_number(getSimHandle(),
-				 lCmdId, &lNumEntries) != REG_SUCCESS)
+          if (mExecutor->call(REG_CALL_SITE("Get_chk_log_number"),
+			      boost::bind(Get_chk_log_number, getSimHandle(),
+					  lCmdId, &lNumEntries)) != REG_SUCCESS)
             THROWEXCEPTION("Get_chk_log_number");
-          mMutexPtr->unlock();
 
           if (lNumEntries > 0){
             // get list of ChkTags from log
             lChkPtForm = new ChkPtForm(lNumEntries, getSimHandle(), lCmdId,
-				       mMutexPtr, this);
+				       mExecutor, this);
 
             if (lChkPtForm->getLibReturnStatus() == REG_SUCCESS){
               if (lChkPtForm->exec() == QDialog::Accepted){
@@ -854,8 +857,10 @@ void IOTypeTable::restartButtonPressedSlot(){
                 sprintf(lCmdParamArray[0], "IN %s",
 			lChkPtForm->getChkTagSelected());
 
-                if (Emit_control(getSimHandle(), 1, lCommandArray,
-				 lCmdParamArray) != REG_SUCCESS){
+                if (mExecutor->callFromGui(REG_CALL_SITE("Emit_control"),
+					   boost::bind(Emit_control, getSimHandle(),
+						       1, lCommandArray,
+						       lCmdParamArray)) != REG_SUCCESS){
                   THROWEXCEPTION("Emit_control");
                 }
                 REG_DBGMSG("Sent Restart Commands");
@@ -1042,7 +1047,10 @@ void IOTypeTable::consumeButtonPressedSlot(){
 
       // library call to emit application
       if (lNumAdded > 0){
-        if (Emit_control(getSimHandle(), lNumAdded, lCommandArray, lCmdParamArray) != REG_SUCCESS){
+        if (mExecutor->callFromGui(REG_CALL_SITE("Emit_control"),
+				   boost::bind(Emit_control, getSimHandle(),
+					       lNumAdded, lCommandArray,
+					       lCmdParamArray)) != REG_SUCCESS){
           THROWEXCEPTION("Emit_control");
         }
       }
@@ -1111,8 +1119,10 @@ void IOTypeTable::emitButtonPressedSlot(){
 							REG_IO_OUT);
       // library call to emit application
       if (lNumAdded > 0){
-        if (Emit_control(getSimHandle(), lNumAdded, lCommandArray,
-			 lCmdParamArray) != REG_SUCCESS){
+        if (mExecutor->callFromGui(REG_CALL_SITE("Emit_control"),
+				   boost::bind(Emit_control, getSimHandle(),
+					       lNumAdded, lCommandArray,
+					       lCmdParamArray)) != REG_SUCCESS){
           THROWEXCEPTION("Emit_control");
         }
       }
@@ -0,0 +1,168 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file latencyhistogram.cpp
+    @brief Implementation of the LatencyHistogram class
+    @author Robert Haines */
+
+#include "latencyhistogram.h"
+
+// Bits of precision kept below the leading bit
+static const int kSUB_BITS = 3;
+static const int kSUB_COUNT = 1 << kSUB_BITS;
+// Largest leading bit kept - anything bigger goes in the top bucket
+static const int kMAX_BITS = 40;
+static const unsigned int kNUM_BUCKETS =
+  kSUB_COUNT + (kMAX_BITS - kSUB_BITS + 1) * kSUB_COUNT;
+
+LatencyHistogram::LatencyHistogram()
+  : mCounts(kNUM_BUCKETS, 0), mCount(0), mMax(0), mSum(0.0)
+{
+}
+
+void
+LatencyHistogram::record(const int64_t aMicros)
+{
+  const int64_t lValue = aMicros < 0 ? 0 : aMicros;
+
+  mCounts[bucketIndex(lValue)]++;
+  mCount++;
+  mSum += (double) lValue;
+  if(lValue > mMax)
+    mMax = lValue;
+}
+
+void
+LatencyHistogram::add(const LatencyHistogram &aOther)
+{
+  for(unsigned int i = 0; i < kNUM_BUCKETS; i++)
+    mCounts[i] += aOther.mCounts[i];
+  mCount += aOther.mCount;
+  mSum += aOther.mSum;
+  if(aOther.mMax > mMax)
+    mMax = aOther.mMax;
+}
+
+void
+LatencyHistogram::reset()
+{
+  mCounts.assign(kNUM_BUCKETS, 0);
+  mCount = 0;
+  mMax = 0;
+  mSum = 0.0;
+}
+
+unsigned long
+LatencyHistogram::getCount() const
+{
+  return mCount;
+}
+
+int64_t
+LatencyHistogram::getMax() const
+{
+  return mMax;
+}
+
+double
+LatencyHistogram::getMean() const
+{
+  return mCount ? mSum / (double) mCount : 0.0;
+}
+
+int64_t
+LatencyHistogram::getPercentile(const double aPercent) const
+{
+  if(mCount == 0)
+    return 0;
+
+  // The rank of the sample we want, counting from 1
+  unsigned long lRank = (unsigned long)(aPercent / 100.0 * mCount + 0.5);
+  if(lRank < 1)
+    lRank = 1;
+
+  unsigned long lSeen = 0;
+  for(unsigned int i = 0; i < kNUM_BUCKETS; i++) {
+    lSeen += mCounts[i];
+    if(lSeen >= lRank) {
+      // Never claim more than we've actually seen
+      const int64_t lTop = bucketTop(i);
+      return lTop < mMax ? lTop : mMax;
+    }
+  }
+  return mMax;
+}
+
+unsigned int
+LatencyHistogram::bucketIndex(const int64_t aMicros)
+{
+  if(aMicros < kSUB_COUNT)
+    return (unsigned int) aMicros;
+
+  int lBit = 63;
+  while(!((aMicros >> lBit) & 1))
+    lBit--;
+  if(lBit > kMAX_BITS)
+    return kNUM_BUCKETS - 1;
+
+  const int lSub = (int)(aMicros >> (lBit - kSUB_BITS)) & (kSUB_COUNT - 1);
+  return kSUB_COUNT + (lBit - kSUB_BITS) * kSUB_COUNT + lSub;
+}
+
+int64_t
+LatencyHistogram::bucketTop(const unsigned int aIndex)
+{
+  if(aIndex < (unsigned int) kSUB_COUNT)
+    return aIndex;
+
+  const int lBit = (aIndex - kSUB_COUNT) / kSUB_COUNT + kSUB_BITS;
+  const int64_t lSub = (aIndex - kSUB_COUNT) % kSUB_COUNT;
+  const int64_t lWidth = (int64_t) 1 << (lBit - kSUB_BITS);
+
+  return (kSUB_COUNT + lSub) * lWidth + lWidth - 1;
+}
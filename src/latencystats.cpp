@@ -0,0 +1,181 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file latencystats.cpp
+    @brief Implementation of the LatencyStats class
+    @author Robert Haines */
+
+#include <QDateTime>
+#include <QFile>
+#include <QTextStream>
+
+#include "buildconfig.h"
+#include "latencystats.h"
+#include "debug.h"
+
+#include "ReG_Steer_Steerside.h"
+
+LatencyStats::LatencyStats()
+{
+}
+
+int64_t
+LatencyStats::now() const
+{
+  return (int64_t)(mClock.getTimed() * 1000.0);
+}
+
+void
+LatencyStats::record(const int aSimHandle, const int aMsgType,
+		     const Stamps &aStamps)
+{
+  QMutexLocker lLock(&mMutex);
+
+  add(aSimHandle, aMsgType, kCONSUME, aStamps.mReceived, aStamps.mConsumed);
+  add(aSimHandle, aMsgType, kQUEUE, aStamps.mConsumed, aStamps.mQueued);
+  add(aSimHandle, aMsgType, kDISPATCH, aStamps.mQueued, aStamps.mDispatched);
+  add(aSimHandle, aMsgType, kDISPLAY, aStamps.mDispatched, aStamps.mShown);
+  add(aSimHandle, aMsgType, kTOTAL, aStamps.mReceived, aStamps.mShown);
+}
+
+void
+LatencyStats::reset()
+{
+  QMutexLocker lLock(&mMutex);
+  mEntries.clear();
+}
+
+QString
+LatencyStats::getReport() const
+{
+  QMutexLocker lLock(&mMutex);
+  std::map<Key, Entry>::const_iterator lIt;
+
+  QString lReport = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+    .arg("Sim", 4).arg("Message", -11).arg("Stage", -9).arg("Count", 8)
+    .arg("Mean ms", 9).arg("p50 ms", 9).arg("p90 ms", 9).arg("p99 ms", 9)
+    .arg("Max ms", 9);
+
+  for(lIt = mEntries.begin(); lIt != mEntries.end(); ++lIt) {
+    for(int i = 0; i < kNUM_STAGES; i++) {
+      const LatencyHistogram &lHist = lIt->second.mStages[i];
+      if(lHist.getCount() == 0)
+	continue;
+
+      lReport += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+	.arg(lIt->first.first, 4)
+	.arg(msgTypeName(lIt->first.second), -11)
+	.arg(stageName((Stage) i), -9)
+	.arg(lHist.getCount(), 8)
+	.arg(lHist.getMean() / 1000.0, 9, 'f', 3)
+	.arg(lHist.getPercentile(50.0) / 1000.0, 9, 'f', 3)
+	.arg(lHist.getPercentile(90.0) / 1000.0, 9, 'f', 3)
+	.arg(lHist.getPercentile(99.0) / 1000.0, 9, 'f', 3)
+	.arg(lHist.getMax() / 1000.0, 9, 'f', 3);
+    }
+  }
+
+  return lReport;
+}
+
+bool
+LatencyStats::dump(const QString &aFileName) const
+{
+  QFile lFile(aFileName);
+
+  if(!lFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    REG_DBGMSG1("LatencyStats::dump: can't open ", aFileName.ascii());
+    return false;
+  }
+
+  QTextStream lStream(&lFile);
+  lStream << "# Steerer message latencies, "
+	  << QDateTime::currentDateTime().toString(Qt::ISODate) << "\n"
+	  << getReport();
+
+  return true;
+}
+
+QString
+LatencyStats::msgTypeName(const int aMsgType)
+{
+  switch(aMsgType) {
+  case IO_DEFS:    return "IO_DEFS";
+  case CHK_DEFS:   return "CHK_DEFS";
+  case PARAM_DEFS: return "PARAM_DEFS";
+  case STATUS:     return "STATUS";
+  case STEER_LOG:  return "STEER_LOG";
+  case CONTROL:    return "CONTROL";
+  case SUPP_CMDS:  return "SUPP_CMDS";
+  default:         return QString::number(aMsgType);
+  }
+}
+
+QString
+LatencyStats::stageName(const Stage aStage)
+{
+  switch(aStage) {
+  case kCONSUME:  return "consume";
+  case kQUEUE:    return "queue";
+  case kDISPATCH: return "dispatch";
+  case kDISPLAY:  return "display";
+  case kTOTAL:    return "total";
+  default:        return "?";
+  }
+}
+
+void
+LatencyStats::add(const int aSimHandle, const int aMsgType,
+		  const Stage aStage, const int64_t aFrom,
+		  const int64_t aTo)
+{
+  if(aFrom < 0 || aTo < 0)
+    return;
+
+  mEntries[Key(aSimHandle, aMsgType)].mStages[aStage].record(aTo - aFrom);
+}
@@ -59,11 +59,16 @@
 
 #include <q3table.h>
 
+#include <float.h>
+#include <math.h>
+
 #include "buildconfig.h"
 #include "parameter.h"
 #include "types.h"
 #include "debug.h"
 
+#include "ReG_Steer_Steerside.h"
+
 Parameter::Parameter(int aId, int aType, bool aSteerable,
 		     QString aLabel)
   : mSteerable(aSteerable), mRegisteredFlag(true),
@@ -159,6 +164,40 @@ void Parameter::setMinMaxStrings(const char *min, const char *max){
   // Make deep copy of the passed strings
   mMinStr = min;
   mMaxStr = max;
+
+  // parse them now rather than every time a new value is checked
+  mMin.parse(mType, min);
+  mMax.parse(mType, max);
+}
+
+bool Parameter::inRange(const ParamValue &aValue) const{
+  if(!aValue.isNumber())
+    return mType == REG_CHAR;
+
+  if(mType == REG_INT){
+    if(mMin.isNumber() && aValue.toInt64() < mMin.toInt64())
+      return false;
+    if(mMax.isNumber() && aValue.toInt64() > mMax.toInt64())
+      return false;
+  }
+  else{
+    // a float has to fit
+    if(mType == REG_FLOAT && fabs(aValue.toDouble()) > FLT_MAX)
+      return false;
+    if(mMin.isNumber() && aValue.toDouble() < mMin.toDouble())
+      return false;
+    if(mMax.isNumber() && aValue.toDouble() > mMax.toDouble())
+      return false;
+  }
+  return true;
+}
+
+void Parameter::setValue(const ParamValue &aValue){
+  mValue = aValue;
+}
+
+const ParamValue &Parameter::getValue() const{
+  return mValue;
 }
 
 QString Parameter::getMinString(){
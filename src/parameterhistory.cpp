@@ -48,52 +48,108 @@
           Robert Haines
  */
 
+#include <limits>
+
 #include "buildconfig.h"
 #include "parameterhistory.h"
+#include "historytable.h"
+
+// What a parameter that hasn't been logged yet has
+static const TypedSeries<double> kNO_VALUES;
 
 ParameterHistory::ParameterHistory(){
-  mArrayChunkSize = 1024;
-  mArraySize = mArrayChunkSize;
-  mArrayPos = 0;
-  mParamHistArray = (double *)malloc(mArraySize*sizeof(double));
-  mPtrPreviousHistArray = NULL;
-  mPreviousHistArraySize = 0;
+  mTable = NULL;
+  mHandle = -1;
 }
 
 ParameterHistory::~ParameterHistory(){
-  if(mParamHistArray)free(mParamHistArray);
-}
-
-// Bear in mind that the current implementation will just sit
-// eating up memory until the job is over... need to do something
-// a bit better and spool to file
-void ParameterHistory::updateParameter(const char* lVal){
-  if(lVal[0] != '\0'){
-    if(mArrayPos < mArraySize){
-      mParamHistArray[mArrayPos++] = (double)atof(lVal);
-    }
-    else{
-      void *dum = realloc((void *)mParamHistArray,
-			  (size_t)(mArraySize+mArrayChunkSize)*sizeof(double));
-      if(dum){
-	mParamHistArray = (double *)dum;
-	mArraySize += mArrayChunkSize;
-	mParamHistArray[mArrayPos++] = (double)atof(lVal);
-      }
-    }
-  }
+}
+
+void ParameterHistory::setTable(const HistoryTable *aTable, const int aHandle){
+  mTable = aTable;
+  mHandle = aHandle;
+}
+
+const HistoryTable *ParameterHistory::getTable() const{
+  return mTable;
 }
 
 const float ParameterHistory::elementAt(int index){
 
-  if(index > 0 && index < mArrayPos){
-    return (float)mParamHistArray[index];
+  if(index > 0 && index < getNumValues() &&
+     index >= getValues().getFirstKept()){
+    return (float)getValues().at(index);
   }
   else{
     return 0.0;
   }
 }
 
-double* ParameterHistory::ptrToArray(){
-  return mParamHistArray;
+const SeriesStore &ParameterHistory::getValues() const{
+  const SeriesStore *lColumn = mTable ? mTable->getColumn(mHandle) : NULL;
+  return lColumn ? *lColumn : kNO_VALUES;
+}
+
+int ParameterHistory::getNumValues() const{
+  return getValues().size();
+}
+
+int ParameterHistory::getFirstRow() const{
+  return mTable ? mTable->getFirstRow(mHandle) : 0;
+}
+
+int ParameterHistory::getFirstKeptRow() const{
+  return mTable ? mTable->getFirstKeptRow(mHandle) : 0;
+}
+
+const HistoryTiers *ParameterHistory::getTiers() const{
+  return mTable ? mTable->getTiers(mHandle) : NULL;
+}
+
+double ParameterHistory::valueAtRow(const int aRow) const{
+  if(!mTable)
+    return std::numeric_limits<double>::quiet_NaN();
+  return mTable->getValue(mHandle, aRow);
+}
+
+bool ParameterHistory::holdsIntegers() const{
+  return mTable && mTable->holdsIntegers(mHandle);
+}
+
+bool ParameterHistory::int64AtRow(const int aRow, int64_t &aValue) const{
+  return mTable && mTable->getInt64Value(mHandle, aRow, aValue);
+}
+
+HistoryTiers::Bucket ParameterHistory::getSummary(const int aFirst,
+						  const int aEnd) const{
+  if(!mTable)
+    return HistoryTiers::Bucket();
+  const int lFirstRow = getFirstRow();
+  return mTable->getSummary(mHandle, lFirstRow + aFirst, lFirstRow + aEnd);
+}
+
+HistoryTiers::Bucket ParameterHistory::getSummaryBySeqNum(const int aFrom,
+							  const int aTo) const{
+  if(!mTable)
+    return HistoryTiers::Bucket();
+  // the first row after aTo is the end, if there can be one
+  const int lEnd = aTo < std::numeric_limits<int>::max() ?
+    mTable->findRow(aTo + 1) : mTable->getNumRows();
+  return mTable->getSummary(mHandle, mTable->findRow(aFrom), lEnd);
+}
+
+int ParameterHistory::getNumLogValues() const{
+  if(!mTable || !mTable->hasLog(mHandle))
+    return 0;
+  return mTable->getNumLogRows();
+}
+
+double ParameterHistory::logValueAt(const int aLogRow) const{
+  return mTable->getLogValue(mHandle, aLogRow);
+}
+
+HistoryTiers::Bucket ParameterHistory::getLogSummary() const{
+  if(!mTable)
+    return HistoryTiers::Bucket();
+  return mTable->getLogSummary(mHandle);
 }
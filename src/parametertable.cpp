@@ -69,11 +69,15 @@
 #include "application.h"
 #include "controlform.h"
 
+#include "regexecutor.h"
+
+#include <boost/bind.hpp>
+
 #include "ReG_Steer_Steerside.h"
 
 ParameterTable::ParameterTable(QWidget *aParent, const char *aName,
-			       int aSimHandle, QMutex *aMutex)
-  : Table(aParent, aName, aSimHandle), mMutexPtr(aMutex),
+			       int aSimHandle, ReGExecutor *aExecutor)
+  : Table(aParent, aName, aSimHandle), mExecutor(aExecutor),
     mParent((ControlForm*)aParent)
 {
   REG_DBGCON("ParameterTable");
@@ -144,8 +148,7 @@ ParameterTable::getNumParameters() const
 }
 
 bool
-ParameterTable::updateRow(const int lHandle, const char *lVal,
-			  const bool isStatusMsg)
+ParameterTable::updateRow(const int lHandle, const ParamValue &aValue)
 {
   // Search list of existing parameters for this lHandle
   // If found update it now
@@ -158,30 +161,18 @@ ParameterTable::updateRow(const int lHandle, const char *lVal,
     // Note: we could make the QTableItem displayed in this cell a
     // member of parameter class  and just update that each time
     // SMR XXX to check.
-    if((lVal[0] != '\0') &&
-       (lParamPtr->getType()==REG_FLOAT || lParamPtr->getType()==REG_DBL)){
-      double lTmp;
-      if(sscanf(lVal, "%lf", &lTmp) == 1){
-	// We do this to improve the formatting of floating point numbers
-	// - removes excessive decimal places.
-	item(lParamPtr->getRowIndex(),
-	     kVALUE_COLUMN)->setText(QString::number(lTmp));
-      }
-      else{
-	item(lParamPtr->getRowIndex(),
-	     kVALUE_COLUMN)->setText(QString(" "));
-      }
-    }
-    else{
-      item(lParamPtr->getRowIndex(), kVALUE_COLUMN)->setText(QString( lVal));
-    }
-
-    updateCell(lParamPtr->getRowIndex(),kVALUE_COLUMN);
 
-    // If this update is a result of a status message then log values
-    // of all parameters except those that are strings
-    if( isStatusMsg && (lParamPtr->getType() != REG_CHAR) ){
-      lParamPtr->mParamHist->updateParameter(lVal);
+    // Nothing to do if the value hasn't changed since last time
+    if(aValue == lParamPtr->getValue())
+      return true;
+    lParamPtr->setValue(aValue);
+    QString lText = aValue.toString();
+
+    // Only redraw the cell if the value has actually changed
+    Q3TableItem *lItem = item(lParamPtr->getRowIndex(), kVALUE_COLUMN);
+    if(lItem->text() != lText){
+      lItem->setText(lText);
+      updateCell(lParamPtr->getRowIndex(),kVALUE_COLUMN);
     }
 
     return true;
@@ -195,7 +186,7 @@ ParameterTable::updateRow(const int lHandle, const char *lVal,
 void
 ParameterTable::addRow(const int lHandle,
 		       const char *lLabel,
-		       const char *lVal,
+		       const ParamValue &aValue,
 		       const int lType)
 {
   // add a new parameter to the table and parameter list
@@ -208,22 +199,16 @@ ParameterTable::addRow(const int lHandle,
 
   Parameter *lParamPtr = new Parameter(lHandle, lType, false,
 				       QString(lLabel));
+  attachHistory(lParamPtr);
 
   setText(lRowIndex, kID_COLUMN,
 	  QString::number(lHandle) );
   setText(lRowIndex, kNAME_COLUMN, lLabel);
   setText(lRowIndex, kREG_COLUMN, "Yes");
 
-  if( (lVal[0] != '\0') && (lType == REG_FLOAT || lType == REG_DBL) ){
-    double lTmp;
-    sscanf(lVal, "%lf", &lTmp);
-    setItem(lRowIndex, kVALUE_COLUMN,
-	    new Q3TableItem(this, Q3TableItem::Never,  QString::number(lTmp)));
-  }
-  else{
-    setItem(lRowIndex, kVALUE_COLUMN,
-	    new Q3TableItem(this, Q3TableItem::Never,  QString( lVal)));
-  }
+  lParamPtr->setValue(aValue);
+  setItem(lRowIndex, kVALUE_COLUMN,
+	  new Q3TableItem(this, Q3TableItem::Never, aValue.toString()));
   lParamPtr->setIndex(lRowIndex);
 
   // Don't store this initial value in the parameter's history because
@@ -344,6 +329,71 @@ Parameter* ParameterTable::findParameterFromLabel(const QString &label)
   return kNULL;
 }
 
+//-------------------------------------------------------------------
+void ParameterTable::attachHistory(Parameter *aParam)
+{
+  if(!mParent || !mParent->application())
+    return;
+
+  HistoryTable *lHistory = mParent->application()->getHistoryTable();
+  aParam->mParamHist->setTable(lHistory, aParam->getId());
+
+  // Logs are spliced in front of the values logged since attaching
+  // by the sequence numbers in SEQUENCE_NUM's log
+  if(aParam->getLabel() == "SEQUENCE_NUM")
+    lHistory->setSeqNumHandle(aParam->getId());
+
+  useCachedHistory(aParam);
+}
+
+//-------------------------------------------------------------------
+void ParameterTable::useCachedHistory(Parameter *aParam)
+{
+  if(!mParent || !mParent->application())
+    return;
+
+  // Until the log is fetched, use what we had from the last attach.
+  // The table has it from now on.
+  HistoryCache *lCache = mParent->application()->getHistoryCache();
+  std::vector<double> lCached;
+  if(lCache && lCache->take(aParam->getLabel(), lCached))
+    mParent->application()->getHistoryTable()->setCachedLog(aParam->getId(),
+							    lCached);
+}
+
+//-------------------------------------------------------------------
+void ParameterTable::useCachedHistories()
+{
+  Parameter *lParamPtr;
+  Q3PtrListIterator<Parameter> lParamIterator( mParamList );
+  lParamIterator.toFirst();
+  while ( (lParamPtr = lParamIterator.current()) != 0){
+    useCachedHistory(lParamPtr);
+    ++lParamIterator;
+  }
+}
+
+//-------------------------------------------------------------------
+void ParameterTable::getHistoryTimelines(HistoryCache::SeriesMap &aSeries)
+{
+  if(!mParent || !mParent->application())
+    return;
+
+  HistoryTable *lHistory = mParent->application()->getHistoryTable();
+  Parameter *lParamPtr;
+  Q3PtrListIterator<Parameter> lParamIterator( mParamList );
+  lParamIterator.toFirst();
+  while ( (lParamPtr = lParamIterator.current()) != 0){
+    HistoryCache::Series &lSeries = aSeries[lParamPtr->getLabel()];
+    lSeries.mIsInteger = lHistory->holdsIntegers(lParamPtr->getId());
+    if(lSeries.mIsInteger)
+      lHistory->getTimeline(lParamPtr->getId(), lSeries.mIntegers);
+    else
+      lHistory->getTimeline(lParamPtr->getId(), lSeries.mValues);
+    ++lParamIterator;
+  }
+}
+
 //-------------------------------------------------------------------
 void
 ParameterTable::clearAndDisableForDetach(const bool aUnRegister)
@@ -423,10 +473,10 @@ void ParameterTable::requestParamHistorySlot(int row){
     lSeqParameter = this->findParameterHandleFromRow(0);
   }
   if( !(lSeqParameter->mHaveFullHistory) ){
-    mMutexPtr->lock();
-    status = Emit_retrieve_param_log_cmd(this->getSimHandle() ,
-					 lSeqParameter->getId()); //ReG library
-    mMutexPtr->unlock();
+    status = mExecutor->call(REG_CALL_SITE("Emit_retrieve_param_log_cmd"), //ReG library
+			     boost::bind(Emit_retrieve_param_log_cmd,
+					 this->getSimHandle(),
+					 lSeqParameter->getId()));
     if(status == REG_SUCCESS){
       lSeqParameter->mHaveFullHistory = true;
     }
@@ -439,10 +489,10 @@ void ParameterTable::requestParamHistorySlot(int row){
 
   if( !(tParameter->mHaveFullHistory) ){
 
-    mMutexPtr->lock();
-    status = Emit_retrieve_param_log_cmd(this->getSimHandle() ,
-					 tParameter->getId());//ReG library
-    mMutexPtr->unlock();
+    status = mExecutor->call(REG_CALL_SITE("Emit_retrieve_param_log_cmd"), //ReG library
+			     boost::bind(Emit_retrieve_param_log_cmd,
+					 this->getSimHandle(),
+					 tParameter->getId()));
     if(status == REG_SUCCESS){
       tParameter->mHaveFullHistory = true;
     }
@@ -521,23 +571,24 @@ void ParameterTable::updateParameterLog(){
   double    *dum_ptr;
   int        status;
 
+  if(!mParent || !mParent->application())
+    return;
+  HistoryTable *lHistory = mParent->application()->getHistoryTable();
+
   Q3PtrListIterator<Parameter> lParamIterator( mParamList );
   lParamIterator.toFirst();
   while ( (lParamPtr = lParamIterator.current()) != 0){
 
-    mMutexPtr->lock();
-    status = Get_param_log(lhandle,    //ReG library
-			   lParamPtr->getId(),
-			   &(dum_ptr),
-			   &(dum_int));
-    mMutexPtr->unlock();
+    status = mExecutor->callFromGui(REG_CALL_SITE("Get_param_log"),    //ReG library
+				    boost::bind(Get_param_log, lhandle,
+						lParamPtr->getId(),
+						&(dum_ptr), &(dum_int)));
 
     if(status == REG_SUCCESS){
-      lParamPtr->mParamHist->mPtrPreviousHistArray = dum_ptr;
-      lParamPtr->mParamHist->mPreviousHistArraySize = dum_int;
+      // The whole log takes over from any from the HistoryCache
+      lHistory->setLog(lParamPtr->getId(), dum_ptr, dum_int);
       //cout << "ARPDBG: handle = "<< lParamPtr->getId() <<
-      //", size of history = "  <<
-      //lParamPtr->mParamHist->mPreviousHistArraySize << endl;
+      //", size of history = "  << dum_int << endl;
       //for(int i=0; i < dum_int; i++){
       //  cout << QString("  %1").arg(dum_ptr[i], 0, 'e', 8);
       //}
@@ -546,7 +597,7 @@ void ParameterTable::updateParameterLog(){
 
     // This allows user to see that we're receiving data but
     // slows things down so left out for the minute.
-    //if(lParamPtr->mParamHist->mPreviousHistArraySize){
+    //if(dum_int){
     //  emit paramUpdateSignal(lParamPtr->mParamHist, lParamPtr->getId());
     //}
 
@@ -557,8 +608,8 @@ void ParameterTable::updateParameterLog(){
 
 SteeredParameterTable::SteeredParameterTable(QWidget *aParent, const char *aName,
 					     ParameterTable *aTable, int aSimHandle,
-					     QMutex *aMutex)
-  : ParameterTable(aParent, aName, aSimHandle, aMutex)
+					     ReGExecutor *aExecutor)
+  : ParameterTable(aParent, aName, aSimHandle, aExecutor)
 {
   REG_DBGCON("SteeredParameterTable");
 
@@ -649,18 +700,8 @@ SteeredParameterTable::validateValueSlot( int aRow, int aCol )
     if  (lParamPtr == kNULL)
       THROWEXCEPTION("Failed to find parameter in list");
 
-    bool noMinValue = false;
-    bool noMaxValue = false;
-    const char *minString = lParamPtr->getMinString().latin1();
-    const char *maxString = lParamPtr->getMaxString().latin1();
-    if (strcmp(minString, "--") == 0)
-      noMinValue = true;
-    if (strcmp(maxString, "--") == 0)
-      noMaxValue = true;
-
-    // validate what user has entered - currently just validate it is correct type
-    // SMR XXX future - add more validation when range supported - will mean calling parameter member func
-    // as ranges will be held on parameter class
+    // validate what user has entered against the parameter's type
+    // and limits - the limits were parsed when the parameter was added
     if (lOk)
     {
       // always allow empty entry - means user is clearing the cell.
@@ -670,59 +711,16 @@ SteeredParameterTable::validateValueSlot( int aRow, int aCol )
         switch(lParamPtr->getType())
         {
             case REG_INT:
-            {
-              int newInt = newVal.toInt( &lOk );
-              // Now check to see if the values the user's entered are legal
-              if (lOk && !noMinValue){
-                 int min = atoi(minString);
-                 if (newInt < min)
-                   lOk = false;
-              }
-              if (lOk && !noMaxValue){
-                int max = atoi(maxString);
-                if (newInt > max)
-                  lOk = false;
-              }
-              break;
-            }
-
             case REG_FLOAT:
-            {
-              float newFloat = newVal.toFloat( &lOk );
-              // Now check to see if the values the user's entered are legal
-              if (lOk && !noMinValue){
-                 float min = float(atof(minString));
-                 if (newFloat < min)
-                   lOk = false;
-              }
-              if (lOk && !noMaxValue){
-                float max = float(atof(maxString));
-                if (newFloat > max)
-                  lOk = false;
-              }
-              break;
-            }
-
             case REG_DBL:
+            case REG_CHAR:
             {
-              double newDouble = newVal.toDouble( &lOk );
-              // Now check to see if the values the user's entered are legal
-              if (lOk && !noMinValue){
-                 double min = atof(minString);
-                 if (newDouble < min)
-                   lOk = false;
-              }
-              if (lOk && !noMaxValue){
-                double max = atof(maxString);
-                if (newDouble > max)
-                  lOk = false;
-              }
+              ParamValue lNewValue;
+              lNewValue.parse(lParamPtr->getType(), newVal.latin1());
+              lOk = lParamPtr->inRange(lNewValue);
               break;
             }
 
-            case REG_CHAR:
-              break;
-
             default:
               THROWEXCEPTION("Unknown parameter type");
         }
@@ -767,7 +765,7 @@ SteeredParameterTable::validateValueSlot( int aRow, int aCol )
 
 
 void
-SteeredParameterTable::addRow(const int lHandle, const char *lLabel, const char *lVal, const int lType, const char *lMinVal, const char *lMaxVal)
+SteeredParameterTable::addRow(const int lHandle, const char *lLabel, const ParamValue &aValue, const int lType, const char *lMinVal, const char *lMaxVal)
 {
 
   // add new steered parameter to table and list
@@ -786,14 +784,16 @@ SteeredParameterTable::addRow(const int lHandle, const char *lLabel, const char
   Parameter *lParamPtr = new Parameter(lHandle, lType, true,
 				       QString(lLabel));
   lParamPtr->setMinMaxStrings(lMinVal, lMaxVal);
+  attachHistory(lParamPtr);
 
   setText(lRowIndex, kID_COLUMN,
 	     QString::number(lHandle) );
   setText(lRowIndex, kNAME_COLUMN, lLabel);
   setText(lRowIndex, kREG_COLUMN, "Yes");
 
+  lParamPtr->setValue(aValue);
   setItem(lRowIndex, kVALUE_COLUMN,
-	     new Q3TableItem(this, Q3TableItem::Never,  QString( lVal)));
+	     new Q3TableItem(this, Q3TableItem::Never, aValue.toString()));
   setItem(lRowIndex, kNEWVALUE_COLUMN,
 	     new Q3TableItem(this, Q3TableItem::OnTyping,  QString::null));
 
@@ -875,13 +875,11 @@ SteeredParameterTable::setNewParamValuesInLib()
 
       int lReGStatus = REG_FAILURE;
 
-      mMutexPtr->lock();
       // set the values in the steering library
-      lReGStatus = Set_param_values(getSimHandle(), //ReG library
-				    lIndex,
-				    lHandles,
-				    lVals);
-      mMutexPtr->unlock();
+      lReGStatus = mExecutor->call(REG_CALL_SITE("Set_param_values"), //ReG library
+				   boost::bind(Set_param_values,
+					       getSimHandle(), lIndex,
+					       lHandles, lVals));
 
       if (lReGStatus != REG_SUCCESS)
       {
@@ -935,13 +933,10 @@ void SteeredParameterTable::emitValuesSlot()
     if (setNewParamValuesInLib() > 0)
     {
 
-      mMutexPtr->lock();
       // call ReG library function to "emit" values to steered application
-      lReGStatus = Emit_control(getSimHandle(),		//ReG library
-				0,
-				NULL,
-				NULL);
-      mMutexPtr->unlock();
+      lReGStatus = mExecutor->callFromGui(REG_CALL_SITE("Emit_control"),		//ReG library
+					  boost::bind(Emit_control, getSimHandle(),
+						      0, (int*)NULL, (char**)NULL));
 
       if (lReGStatus != REG_SUCCESS)
 	THROWEXCEPTION("Emit_contol");
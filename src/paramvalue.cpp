@@ -0,0 +1,294 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file paramvalue.cpp
+    @brief Implementation of the ParamValue class
+    @author Robert Haines */
+
+#include <QLocale>
+
+#include <stdint.h>
+
+#include "buildconfig.h"
+#include "paramvalue.h"
+
+#include "ReG_Steer_Steerside.h"
+
+// Powers of ten that a double holds exactly
+static const double kPOW10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int kMAX_POW10 = 22;
+// Largest integer a double holds exactly
+static const uint64_t kMAX_EXACT = (uint64_t) 1 << 53;
+// Largest int64_t
+static const int64_t kMAX_INT64 = (int64_t) (((uint64_t) 1 << 63) - 1);
+// Most decimal digits that always fit in a uint64_t
+static const int kMAX_DIGITS = 19;
+
+static inline bool
+isSpace(const char aChar)
+{
+  return aChar == ' ' || aChar == '\t' || aChar == '\n' || aChar == '\r';
+}
+
+static inline bool
+isDigit(const char aChar)
+{
+  return aChar >= '0' && aChar <= '9';
+}
+
+ParamValue::ParamValue()
+  : mType(REG_CHAR), mIsNumber(false), mInt(0), mDouble(0.0)
+{
+}
+
+void
+ParamValue::parse(const int aType, const char *aText)
+{
+  mType = aType;
+  mInt = 0;
+  mDouble = 0.0;
+
+  switch(aType){
+  case REG_INT:
+    mIsNumber = parseInt(aText, mInt);
+    mDouble = mInt;
+    break;
+  case REG_FLOAT:
+  case REG_DBL:
+    mIsNumber = parseDouble(aText, mDouble);
+    break;
+  default:
+    mIsNumber = false;
+    break;
+  }
+
+  if(mIsNumber)
+    mText = QString::null;
+  else
+    mText = aText;
+}
+
+int
+ParamValue::getType() const
+{
+  return mType;
+}
+
+bool
+ParamValue::isNumber() const
+{
+  return mIsNumber;
+}
+
+int64_t
+ParamValue::toInt64() const
+{
+  return mInt;
+}
+
+double
+ParamValue::toDouble() const
+{
+  return mDouble;
+}
+
+QString
+ParamValue::toString() const
+{
+  if(mIsNumber){
+    if(mType == REG_INT)
+      return QString::number((qlonglong) mInt);
+    return QString::number(mDouble);
+  }
+
+  // floating point values that don't parse are blanked out
+  if((mType == REG_FLOAT || mType == REG_DBL) && !mText.isEmpty())
+    return QString(" ");
+  return mText;
+}
+
+bool
+ParamValue::operator==(const ParamValue &aOther) const
+{
+  if(mType != aOther.mType || mIsNumber != aOther.mIsNumber)
+    return false;
+  if(mIsNumber)
+    return mType == REG_INT ? mInt == aOther.mInt :
+      mDouble == aOther.mDouble;
+  return mText == aOther.mText;
+}
+
+bool
+ParamValue::parseDouble(const char *aText, double &aValue)
+{
+  const char *lPos = aText;
+  uint64_t lMantissa = 0;
+  int      lDigits = 0;
+  int      lExponent = 0;
+  bool     lExact = true;
+  bool     lAnyDigits = false;
+  bool     lNegative = false;
+
+  while(isSpace(*lPos))
+    lPos++;
+  if(*lPos == '-' || *lPos == '+')
+    lNegative = (*lPos++ == '-');
+
+  // Take up to kMAX_DIGITS significant digits into the mantissa
+  for(; isDigit(*lPos); lPos++){
+    lAnyDigits = true;
+    if(lMantissa == 0 && *lPos == '0')
+      continue;
+    if(lDigits < kMAX_DIGITS){
+      lMantissa = lMantissa * 10 + (*lPos - '0');
+      lDigits++;
+    }
+    else{
+      lExponent++;
+      lExact = lExact && (*lPos == '0');
+    }
+  }
+  if(*lPos == '.'){
+    for(lPos++; isDigit(*lPos); lPos++){
+      lAnyDigits = true;
+      if(lMantissa == 0 && *lPos == '0'){
+	lExponent--;
+	continue;
+      }
+      if(lDigits < kMAX_DIGITS){
+	lMantissa = lMantissa * 10 + (*lPos - '0');
+	lDigits++;
+	lExponent--;
+      }
+      else{
+	lExact = lExact && (*lPos == '0');
+      }
+    }
+  }
+
+  if(lAnyDigits && (*lPos == 'e' || *lPos == 'E')){
+    const char *lExpPos = lPos + 1;
+    bool lExpNegative = false;
+    int  lExpValue = 0;
+
+    if(*lExpPos == '-' || *lExpPos == '+')
+      lExpNegative = (*lExpPos++ == '-');
+    if(isDigit(*lExpPos)){
+      for(; isDigit(*lExpPos); lExpPos++){
+	// anything this big is out of range anyway
+	if(lExpValue < 100000)
+	  lExpValue = lExpValue * 10 + (*lExpPos - '0');
+      }
+      lExponent += lExpNegative ? -lExpValue : lExpValue;
+      lPos = lExpPos;
+    }
+  }
+
+  while(isSpace(*lPos))
+    lPos++;
+
+  if(lAnyDigits && *lPos == '\0' && lMantissa == 0){
+    aValue = lNegative ? -0.0 : 0.0;
+    return true;
+  }
+  if(lAnyDigits && *lPos == '\0' && lExact && lMantissa <= kMAX_EXACT &&
+     lExponent >= -kMAX_POW10 && lExponent <= kMAX_POW10){
+    // Both the mantissa and the power of ten are exact so one
+    // multiplication or division gives the correctly rounded result
+    double lValue = (double) lMantissa;
+    if(lExponent < 0)
+      lValue /= kPOW10[-lExponent];
+    else
+      lValue *= kPOW10[lExponent];
+    aValue = lNegative ? -lValue : lValue;
+    return true;
+  }
+
+  // Too many digits, too big, too small, inf, nan or not a number at
+  // all - leave it to Qt, which always uses the C locale
+  bool lOk = false;
+  const double lValue =
+    QLocale::c().toDouble(QString::fromLatin1(aText).trimmed(), &lOk);
+  if(lOk)
+    aValue = lValue;
+  return lOk;
+}
+
+bool
+ParamValue::parseInt(const char *aText, int64_t &aValue)
+{
+  const char *lPos = aText;
+  int64_t lValue = 0;
+  bool    lNegative = false;
+
+  while(isSpace(*lPos))
+    lPos++;
+  if(*lPos == '-' || *lPos == '+')
+    lNegative = (*lPos++ == '-');
+  if(!isDigit(*lPos))
+    return false;
+
+  // the same range either side of zero so it can't overflow
+  for(; isDigit(*lPos); lPos++){
+    const int lDigit = *lPos - '0';
+    if(lValue > (kMAX_INT64 - lDigit) / 10)
+      return false;
+    lValue = lValue * 10 + lDigit;
+  }
+
+  while(isSpace(*lPos))
+    lPos++;
+  if(*lPos != '\0')
+    return false;
+
+  aValue = lNegative ? -lValue : lValue;
+  return true;
+}
@@ -0,0 +1,331 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file pollscheduler.cpp
+    @brief Implementation of the PollScheduler class
+    @author Robert Haines */
+
+#include "buildconfig.h"
+#include "pollscheduler.h"
+#include "types.h"
+#include "debug.h"
+
+#include "ReG_Steer_Steerside.h"
+
+// Weight given to the newest sample in the smoothed estimates
+static const float kEWMA_WEIGHT = 0.2f;
+// How many mean deviations early to start polling for the next
+// expected message
+static const float kJITTER_MARGIN = 2.0f;
+
+PollScheduler::PollScheduler(const int aInterval, const int aLatencyTarget)
+  : mInterval(aInterval), mLatencyTarget(aLatencyTarget), mAutoAdjust(true),
+    mNextGeneration(0)
+{
+}
+
+void
+PollScheduler::addApplication(const int aSimHandle)
+{
+  QMutexLocker lLock(&mMutex);
+  AppState &lState = mApps[aSimHandle];
+
+  resetState(lState, mInterval);
+  schedule(aSimHandle, lState, mClock.getTime64());
+}
+
+void
+PollScheduler::removeApplication(const int aSimHandle)
+{
+  QMutexLocker lLock(&mMutex);
+  // Its queue entries are discarded lazily
+  mApps.erase(aSimHandle);
+}
+
+void
+PollScheduler::setPaused(const int aSimHandle, const bool aPaused)
+{
+  QMutexLocker lLock(&mMutex);
+  std::map<int, AppState>::iterator lIt = mApps.find(aSimHandle);
+
+  if(lIt == mApps.end() || lIt->second.mPaused == aPaused)
+    return;
+
+  lIt->second.mPaused = aPaused;
+  if(aPaused)
+    // Its queue entry is discarded lazily
+    lIt->second.mGeneration = mNextGeneration++;
+  else
+    schedule(aSimHandle, lIt->second, mClock.getTime64());
+}
+
+void
+PollScheduler::recordPoll(const int aSimHandle, const int aMsgType)
+{
+  QMutexLocker lLock(&mMutex);
+  const int64_t lNow = mClock.getTime64();
+  const bool lGotMsg = (aMsgType != MSG_NOTSET) && (aMsgType != MSG_ERROR);
+  std::vector<int> lPolled;
+
+  discardStale();
+  while(!mQueue.empty() && mQueue.top().mDue <= lNow) {
+    lPolled.push_back(mQueue.top().mSimHandle);
+    mQueue.pop();
+    discardStale();
+  }
+
+  // An application that answered was polled whether it was due or not
+  std::map<int, AppState>::iterator lIt = mApps.find(aSimHandle);
+  if(lGotMsg && lIt != mApps.end() && !lIt->second.mPaused &&
+     lIt->second.mDue > lNow)
+    lPolled.push_back(aSimHandle);
+
+  for(unsigned int i = 0; i < lPolled.size(); i++) {
+    AppState &lState = mApps[lPolled[i]];
+    const bool lAnswered = lGotMsg && (lPolled[i] == aSimHandle);
+
+    // Only learn once the application is up and running
+    if(lState.mSeenStatus)
+      lState.mHitRatio += kEWMA_WEIGHT *
+	((lAnswered ? 1.0f : 0.0f) - lState.mHitRatio);
+
+    if(mAutoAdjust)
+      lState.mInterval = nextInterval(lState, lNow);
+    schedule(lPolled[i], lState, lNow + lState.mInterval);
+  }
+}
+
+void
+PollScheduler::recordMessage(const int aSimHandle, const int aMsgType)
+{
+  if(aMsgType != STATUS)
+    return;
+
+  QMutexLocker lLock(&mMutex);
+  std::map<int, AppState>::iterator lIt = mApps.find(aSimHandle);
+  // Messages read while paused turn up in bursts, so don't learn
+  // from them
+  if(lIt == mApps.end() || lIt->second.mPaused)
+    return;
+
+  const int64_t lNow = mClock.getTime64();
+  AppState &lState = lIt->second;
+  lState.mSeenStatus = true;
+  recordArrival(lState, lNow);
+
+  // The next one is now expected at a different time
+  if(mAutoAdjust) {
+    lState.mInterval = nextInterval(lState, lNow);
+    schedule(aSimHandle, lState, lNow + lState.mInterval);
+  }
+}
+
+int
+PollScheduler::msecsUntilDue(const int aDefault)
+{
+  QMutexLocker lLock(&mMutex);
+
+  discardStale();
+  if(mQueue.empty())
+    return aDefault;
+
+  int64_t lWait = mQueue.top().mDue - mClock.getTime64();
+  return lWait > 0 ? (int) lWait : 0;
+}
+
+void
+PollScheduler::setAutoAdjust(const bool aFlag)
+{
+  QMutexLocker lLock(&mMutex);
+  std::map<int, AppState>::iterator lIt;
+
+  // Go back to the fixed interval straight away
+  if(!aFlag) {
+    for(lIt = mApps.begin(); lIt != mApps.end(); ++lIt)
+      lIt->second.mInterval = mInterval;
+  }
+  mAutoAdjust = aFlag;
+}
+
+void
+PollScheduler::setInterval(const int aInterval)
+{
+  QMutexLocker lLock(&mMutex);
+  std::map<int, AppState>::iterator lIt;
+  const int64_t lNow = mClock.getTime64();
+
+  mInterval = aInterval;
+  for(lIt = mApps.begin(); lIt != mApps.end(); ++lIt) {
+    lIt->second.mInterval = aInterval;
+    if(!lIt->second.mPaused)
+      schedule(lIt->first, lIt->second, lNow + aInterval);
+  }
+}
+
+int
+PollScheduler::getInterval() const
+{
+  QMutexLocker lLock(&mMutex);
+  std::map<int, AppState>::const_iterator lIt;
+  int lMin = -1;
+
+  for(lIt = mApps.begin(); lIt != mApps.end(); ++lIt) {
+    if(lMin < 0 || lIt->second.mInterval < lMin)
+      lMin = lIt->second.mInterval;
+  }
+  return lMin < 0 ? mInterval : lMin;
+}
+
+void
+PollScheduler::setLatencyTarget(const int aLatencyTarget)
+{
+  QMutexLocker lLock(&mMutex);
+  mLatencyTarget = aLatencyTarget;
+}
+
+int
+PollScheduler::getLatencyTarget() const
+{
+  QMutexLocker lLock(&mMutex);
+  return mLatencyTarget;
+}
+
+bool
+PollScheduler::getStats(const int aSimHandle, AppStats &aStats) const
+{
+  QMutexLocker lLock(&mMutex);
+  std::map<int, AppState>::const_iterator lIt = mApps.find(aSimHandle);
+
+  if(lIt == mApps.end())
+    return false;
+
+  aStats.mInterval = lIt->second.mInterval;
+  aStats.mHitRatio = lIt->second.mHitRatio;
+  aStats.mMeanGap = lIt->second.mMeanGap;
+  return true;
+}
+
+void
+PollScheduler::resetState(AppState &aState, const int aInterval)
+{
+  aState.mInterval = aInterval;
+  aState.mDue = 0;
+  aState.mPaused = false;
+  aState.mSeenStatus = false;
+  aState.mHitRatio = 0.0f;
+  aState.mLastArrival = -1;
+  aState.mMeanGap = -1.0f;
+  aState.mGapDeviation = 0.0f;
+}
+
+void
+PollScheduler::schedule(const int aSimHandle, AppState &aState,
+			const int64_t aDue)
+{
+  aState.mDue = aDue;
+  aState.mGeneration = mNextGeneration++;
+  mQueue.push(QueueEntry(aDue, aSimHandle, aState.mGeneration));
+}
+
+void
+PollScheduler::recordArrival(AppState &aState, const int64_t aNow)
+{
+  if(aState.mLastArrival >= 0) {
+    const float lGap = (float)(aNow - aState.mLastArrival);
+
+    if(aState.mMeanGap < 0.0f) {
+      aState.mMeanGap = lGap;
+      aState.mGapDeviation = 0.5f * lGap;
+    }
+    else {
+      const float lError = lGap - aState.mMeanGap;
+      aState.mMeanGap += kEWMA_WEIGHT * lError;
+      aState.mGapDeviation += kEWMA_WEIGHT *
+	((lError < 0.0f ? -lError : lError) - aState.mGapDeviation);
+    }
+  }
+  aState.mLastArrival = aNow;
+}
+
+int
+PollScheduler::nextInterval(const AppState &aState,
+			    const int64_t aNow) const
+{
+  int lInterval = mLatencyTarget;
+
+  // Nothing is expected for a while so don't poll until just before
+  // it is, allowing for jitter and for the latency target itself
+  if(aState.mMeanGap > 0.0f && aState.mLastArrival >= 0) {
+    const int64_t lExpected = aState.mLastArrival +
+      (int64_t)(aState.mMeanGap - kJITTER_MARGIN * aState.mGapDeviation) -
+      mLatencyTarget;
+    if(lExpected - aNow > lInterval)
+      lInterval = (int)(lExpected - aNow);
+  }
+
+  if(lInterval < kMIN_POLLING_INT)
+    lInterval = kMIN_POLLING_INT;
+  else if(lInterval > kMAX_POLLING_INT)
+    lInterval = kMAX_POLLING_INT;
+
+  return lInterval;
+}
+
+void
+PollScheduler::discardStale()
+{
+  while(!mQueue.empty()) {
+    std::map<int, AppState>::const_iterator lIt =
+      mApps.find(mQueue.top().mSimHandle);
+
+    if(lIt != mApps.end() &&
+       lIt->second.mGeneration == mQueue.top().mGeneration)
+      return;
+    mQueue.pop();
+  }
+}
@@ -0,0 +1,385 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file regexecutor.cpp
+    @brief Implementation of the ReGExecutor class
+    @author Robert Haines */
+
+#include <QCoreApplication>
+
+#include "buildconfig.h"
+#include "regexecutor.h"
+#include "tracerecorder.h"
+#include "debug.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "ReG_Steer_Steerside.h"
+
+// How long callFromGui() waits between handling the GUI's events (ms)
+static const int kGUI_WAIT_SLICE = 20;
+
+/// A task waiting for, or being run by, the executor
+struct ReGRequest {
+  ReGRequest(ReGExecutor *aExecutor, const char *aName,
+	     const ReGExecutor::Task &aTask, const double aQueued)
+    : mExecutor(aExecutor), mName(aName), mTask(aTask), mQueued(aQueued),
+      mFromGui(QCoreApplication::instance() &&
+	       QThread::currentThread() ==
+	       QCoreApplication::instance()->thread()),
+      mResult(REG_FAILURE), mDone(false) {}
+
+  ReGExecutor      *mExecutor;
+  const char       *mName;
+  ReGExecutor::Task mTask;
+  /// When the request was queued (ms)
+  double            mQueued;
+  /// Whether the GUI thread asked for it
+  bool              mFromGui;
+  int               mResult;
+  bool              mDone;
+};
+
+typedef std::pair<std::string, ReGExecutor::CallStats> StatsEntry;
+
+static bool
+moreRunTime(const StatsEntry &aLeft, const StatsEntry &aRight)
+{
+  return aLeft.second.mTotalRunMs > aRight.second.mTotalRunMs;
+}
+
+/// Drop the directory from the file name in a REG_CALL_SITE name
+static QString
+shortSiteName(const std::string &aName)
+{
+  QString lName(aName.c_str());
+  const int lParen = lName.find('(');
+  const int lSlash = lName.findRev('/');
+
+  if(lParen >= 0 && lSlash > lParen)
+    lName = lName.left(lParen + 1) + lName.mid(lSlash + 1);
+  return lName;
+}
+
+ReGExecutor::ReGExecutor()
+  : mKeepRunning(true), mMaxQueueDepth(0), mGuiCallDepth(0)
+{
+  start();
+}
+
+ReGExecutor::~ReGExecutor()
+{
+  stop();
+}
+
+int
+ReGExecutor::call(const char *aName, const Task &aTask)
+{
+  // Queueing from the executor thread itself would deadlock, and once
+  // the thread has stopped nobody else is calling the library
+  if(currentThread() == this || !isRunning()) {
+    ReGRequest lRequest(this, aName, aTask, mClock.getTimed());
+    execute(lRequest);
+    return lRequest.mResult;
+  }
+
+  TraceScope lTrace("wait", aName);
+  Future lFuture = post(aName, aTask);
+  return lFuture.get();
+}
+
+int
+ReGExecutor::callFromGui(const char *aName, const Task &aTask)
+{
+  QCoreApplication *lApp = QCoreApplication::instance();
+  if(!lApp || currentThread() != lApp->thread() || !isRunning())
+    return call(aName, aTask);
+
+  TraceScope lTrace("wait", aName);
+  Future lFuture = post(aName, aTask);
+  // Repaint and take in posted events, but don't let the user start
+  // anything else while we're in the middle of this. Posted events
+  // that could get in the caller's way are put off by deferEvent().
+  mGuiCallDepth++;
+  while(!lFuture.wait(kGUI_WAIT_SLICE))
+    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+  mGuiCallDepth--;
+
+  if(mGuiCallDepth == 0)
+    postDeferredEvents();
+  return lFuture.get();
+}
+
+bool
+ReGExecutor::deferEvent(QObject *aReceiver, const int aType)
+{
+  if(mGuiCallDepth == 0)
+    return false;
+
+  // one of each is enough
+  std::vector<std::pair<QPointer<QObject>, int> >::const_iterator lIt;
+  for(lIt = mDeferredEvents.begin(); lIt != mDeferredEvents.end(); ++lIt){
+    if((QObject *) lIt->first == aReceiver && lIt->second == aType)
+      return true;
+  }
+
+  REG_DBGMSG1("ReGExecutor: putting off event of type ", aType);
+  mDeferredEvents.push_back(std::make_pair(QPointer<QObject>(aReceiver),
+					   aType));
+  return true;
+}
+
+void
+ReGExecutor::postDeferredEvents()
+{
+  std::vector<std::pair<QPointer<QObject>, int> > lEvents;
+  lEvents.swap(mDeferredEvents);
+
+  // the receiver may have been deleted while it waited
+  std::vector<std::pair<QPointer<QObject>, int> >::const_iterator lIt;
+  for(lIt = lEvents.begin(); lIt != lEvents.end(); ++lIt){
+    if(!lIt->first.isNull())
+      QCoreApplication::postEvent(lIt->first,
+				  new QEvent((QEvent::Type) lIt->second));
+  }
+}
+
+ReGExecutor::Future
+ReGExecutor::post(const char *aName, const Task &aTask)
+{
+  Future lFuture;
+  lFuture.mRequest.reset(new ReGRequest(this, aName, aTask,
+					mClock.getTimed()));
+
+  QMutexLocker lLock(&mMutex);
+  if(!mKeepRunning) {
+    // Run it here once the thread has finished with the library;
+    // nothing else is going to
+    lLock.unlock();
+    if(currentThread() != this)
+      wait();
+    execute(*lFuture.mRequest);
+    return lFuture;
+  }
+
+  mQueue.push_back(lFuture.mRequest);
+  mMaxQueueDepth = std::max(mMaxQueueDepth, (unsigned int) mQueue.size());
+  mWorkCondition.wakeOne();
+
+  return lFuture;
+}
+
+void
+ReGExecutor::stop()
+{
+  mMutex.lock();
+  mKeepRunning = false;
+  mWorkCondition.wakeAll();
+  mMutex.unlock();
+
+  wait();
+}
+
+unsigned int
+ReGExecutor::getQueueDepth() const
+{
+  QMutexLocker lLock(&mMutex);
+  return mQueue.size();
+}
+
+unsigned int
+ReGExecutor::getMaxQueueDepth() const
+{
+  QMutexLocker lLock(&mMutex);
+  return mMaxQueueDepth;
+}
+
+std::map<std::string, ReGExecutor::CallStats>
+ReGExecutor::getStats() const
+{
+  QMutexLocker lLock(&mMutex);
+  return mStats;
+}
+
+QString
+ReGExecutor::getStatsReport() const
+{
+  std::map<std::string, CallStats> lStats = getStats();
+  std::vector<StatsEntry> lSorted(lStats.begin(), lStats.end());
+  std::sort(lSorted.begin(), lSorted.end(), moreRunTime);
+
+  QString lReport = QString("Queue depth: %1 (max %2)\n\n")
+    .arg(getQueueDepth()).arg(getMaxQueueDepth());
+  lReport += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+    .arg("Call", -52).arg("Count", 8).arg("GUI", 8)
+    .arg("Run ms", 9).arg("p99 run", 9).arg("Max run", 9)
+    .arg("Wait ms", 9).arg("p99 wait", 9).arg("Max wait", 9);
+
+  for(unsigned int i = 0; i < lSorted.size(); i++) {
+    const CallStats &lCall = lSorted[i].second;
+    lReport += QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+      .arg(shortSiteName(lSorted[i].first), -52)
+      .arg(lCall.mCount, 8)
+      .arg(lCall.mGuiCount, 8)
+      .arg(lCall.mTotalRunMs / lCall.mCount, 9, 'f', 3)
+      .arg(lCall.mRunHist.getPercentile(99.0) / 1000.0, 9, 'f', 3)
+      .arg(lCall.mMaxRunMs, 9, 'f', 3)
+      .arg(lCall.mTotalWaitMs / lCall.mCount, 9, 'f', 3)
+      .arg(lCall.mWaitHist.getPercentile(99.0) / 1000.0, 9, 'f', 3)
+      .arg(lCall.mMaxWaitMs, 9, 'f', 3);
+  }
+
+  return lReport;
+}
+
+void
+ReGExecutor::run()
+{
+  REG_DBGMSG("ReGExecutor starting");
+  TraceRecorder::setThreadName("ReGExecutor");
+
+  mMutex.lock();
+  while(true) {
+    while(mQueue.empty() && mKeepRunning)
+      mWorkCondition.wait(&mMutex);
+
+    // Only stop once everything queued has been run
+    if(mQueue.empty())
+      break;
+
+    boost::shared_ptr<ReGRequest> lRequest = mQueue.front();
+    mQueue.pop_front();
+
+    mMutex.unlock();
+    execute(*lRequest);
+    mMutex.lock();
+  }
+  mMutex.unlock();
+
+  REG_DBGMSG("ReGExecutor stopped");
+}
+
+void
+ReGExecutor::execute(ReGRequest &aRequest)
+{
+  TraceScope lTrace("library", aRequest.mName);
+  const double lStart = mClock.getTimed();
+  const int lResult = aRequest.mTask();
+  const double lEnd = mClock.getTimed();
+  lTrace.finish();
+
+  QMutexLocker lLock(&mMutex);
+  CallStats &lCall = mStats[aRequest.mName];
+  const double lWait = lStart - aRequest.mQueued;
+  const double lRun = lEnd - lStart;
+
+  lCall.mCount++;
+  if(aRequest.mFromGui)
+    lCall.mGuiCount++;
+  lCall.mWaitHist.record((int64_t)(lWait * 1000.0));
+  lCall.mRunHist.record((int64_t)(lRun * 1000.0));
+  lCall.mTotalWaitMs += lWait;
+  lCall.mMaxWaitMs = std::max(lCall.mMaxWaitMs, lWait);
+  lCall.mTotalRunMs += lRun;
+  lCall.mMaxRunMs = std::max(lCall.mMaxRunMs, lRun);
+
+  aRequest.mResult = lResult;
+  aRequest.mDone = true;
+  mDoneCondition.wakeAll();
+}
+
+int
+ReGExecutor::waitFor(ReGRequest &aRequest)
+{
+  QMutexLocker lLock(&mMutex);
+  while(!aRequest.mDone)
+    mDoneCondition.wait(&mMutex);
+  return aRequest.mResult;
+}
+
+bool
+ReGExecutor::waitFor(ReGRequest &aRequest, const int aMsecs)
+{
+  QMutexLocker lLock(&mMutex);
+  if(!aRequest.mDone)
+    mDoneCondition.wait(&mMutex, aMsecs);
+  return aRequest.mDone;
+}
+
+ReGExecutor::Future::Future()
+{
+}
+
+bool
+ReGExecutor::Future::isReady() const
+{
+  if(!mRequest)
+    return false;
+
+  QMutexLocker lLock(&mRequest->mExecutor->mMutex);
+  return mRequest->mDone;
+}
+
+int
+ReGExecutor::Future::get() const
+{
+  if(!mRequest)
+    return REG_FAILURE;
+
+  return mRequest->mExecutor->waitFor(*mRequest);
+}
+
+bool
+ReGExecutor::Future::wait(const int aMsecs) const
+{
+  if(!mRequest)
+    return true;
+
+  return mRequest->mExecutor->waitFor(*mRequest, aMsecs);
+}
@@ -0,0 +1,429 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file seriescodec.cpp
+    @brief Implementation of the SeriesCodec class
+    @author Robert Haines */
+
+#include <string.h>
+#include <stdint.h>
+
+#include "seriescodec.h"
+
+// The first byte of a block says how the rest is encoded
+static const char kCODEC_DELTA = 1;
+static const char kCODEC_XOR = 2;
+static const char kCODEC_XOR_FLOAT = 3;
+
+// Anything bigger than this can't be held exactly as a double anyway
+static const double kMAX_EXACT = 9007199254740992.0;
+
+namespace {
+
+  /// Appends values a few bits at a time, most significant bit first
+  class BitWriter {
+  public:
+    BitWriter(std::vector<char> &aOut) : mOut(aOut), mAcc(0), mBits(0) {}
+
+    void write(const uint64_t aValue, const int aCount) {
+      if(aCount > 32){
+	write(aValue >> 32, aCount - 32);
+	write(aValue & 0xffffffffu, 32);
+	return;
+      }
+      mAcc = (mAcc << aCount) | (aValue & mask(aCount));
+      mBits += aCount;
+      while(mBits >= 8){
+	mBits -= 8;
+	mOut.push_back((char) (mAcc >> mBits));
+      }
+      mAcc &= mask(mBits);
+    }
+    /// Pad out the last byte
+    void flush() {
+      if(mBits > 0)
+	mOut.push_back((char) (mAcc << (8 - mBits)));
+      mAcc = 0;
+      mBits = 0;
+    }
+
+  private:
+    static uint64_t mask(const int aCount) {
+      return aCount >= 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << aCount) - 1;
+    }
+
+    std::vector<char> &mOut;
+    uint64_t           mAcc;
+    int                mBits;
+  };
+
+  /// Reads back what a BitWriter wrote
+  class BitReader {
+  public:
+    BitReader(const char *aData, const size_t aBytes)
+      : mData((const unsigned char *) aData), mBytes(aBytes), mPos(0),
+	mAcc(0), mBits(0), mFailed(false) {}
+
+    uint64_t read(const int aCount) {
+      if(aCount > 32){
+	const uint64_t lHigh = read(aCount - 32);
+	return (lHigh << 32) | read(32);
+      }
+      while(mBits < aCount){
+	if(mPos == mBytes){
+	  mFailed = true;
+	  return 0;
+	}
+	mAcc = (mAcc << 8) | mData[mPos++];
+	mBits += 8;
+      }
+      mBits -= aCount;
+      const uint64_t lValue = (mAcc >> mBits) & (((uint64_t) 1 << aCount) - 1);
+      mAcc &= ((uint64_t) 1 << mBits) - 1;
+      return lValue;
+    }
+    bool readBit() { return read(1) != 0; }
+    bool failed() const { return mFailed; }
+
+  private:
+    const unsigned char *mData;
+    size_t               mBytes;
+    size_t               mPos;
+    uint64_t             mAcc;
+    int                  mBits;
+    bool                 mFailed;
+  };
+
+  uint64_t toBits(const double aValue) {
+    uint64_t lBits;
+    memcpy(&lBits, &aValue, sizeof(lBits));
+    return lBits;
+  }
+
+  uint64_t toBits(const float aValue) {
+    uint32_t lBits;
+    memcpy(&lBits, &aValue, sizeof(lBits));
+    return lBits;
+  }
+
+  void fromBits(const uint64_t aBits, double &aValue) {
+    memcpy(&aValue, &aBits, sizeof(aValue));
+  }
+
+  void fromBits(const uint64_t aBits, float &aValue) {
+    const uint32_t lBits = (uint32_t) aBits;
+    memcpy(&aValue, &lBits, sizeof(aValue));
+  }
+
+  int leadingZeros(const uint64_t aValue) {
+#ifdef __GNUC__
+    return aValue ? __builtin_clzll(aValue) : 64;
+#else
+    int lCount = 0;
+    for(uint64_t lBit = (uint64_t) 1 << 63; lBit && !(aValue & lBit);
+	lBit >>= 1)
+      lCount++;
+    return lCount;
+#endif
+  }
+
+  int trailingZeros(const uint64_t aValue) {
+#ifdef __GNUC__
+    return aValue ? __builtin_ctzll(aValue) : 64;
+#else
+    int lCount = 0;
+    for(uint64_t lBit = 1; lBit && !(aValue & lBit); lBit <<= 1)
+      lCount++;
+    return lCount;
+#endif
+  }
+
+  /// Whether every value is a whole number that a double holds
+  /// exactly (and isn't -0, which would come back as 0)
+  bool allWhole(const double *aValues, const int aCount) {
+    for(int i = 0; i < aCount; i++){
+      const double lValue = aValues[i];
+      if(!(lValue > -kMAX_EXACT && lValue < kMAX_EXACT) ||
+	 lValue != (double) (int64_t) lValue ||
+	 (lValue == 0.0 && (toBits(lValue) >> 63)))
+	return false;
+    }
+    return true;
+  }
+
+  // Delta-of-delta: each value is stored as how much its difference
+  // from the one before differs from the previous difference,
+  // zig-zag encoded so small negative changes stay small, with a
+  // prefix saying how many bits it needs.
+  //   0    - same difference as before
+  //   10   - 7 bits
+  //   110  - 9 bits
+  //   1110 - 12 bits
+  //   1111 - 64 bits
+  // The sums are done unsigned so that they wrap rather than
+  // overflow.
+  template <typename T>
+  void encodeDelta(const T *aValues, const int aCount, BitWriter &aOut) {
+    uint64_t lPrevious = 0;
+    uint64_t lDelta = 0;
+    for(int i = 0; i < aCount; i++){
+      const uint64_t lValue = (uint64_t) (int64_t) aValues[i];
+      const uint64_t lNewDelta = lValue - lPrevious;
+      const int64_t lDod = (int64_t) (lNewDelta - lDelta);
+      const uint64_t lZigZag = ((uint64_t) lDod << 1) ^ (uint64_t) (lDod >> 63);
+
+      if(lZigZag == 0)
+	aOut.write(0, 1);
+      else if(lZigZag < (1u << 7)){
+	aOut.write(2, 2);
+	aOut.write(lZigZag, 7);
+      }
+      else if(lZigZag < (1u << 9)){
+	aOut.write(6, 3);
+	aOut.write(lZigZag, 9);
+      }
+      else if(lZigZag < (1u << 12)){
+	aOut.write(14, 4);
+	aOut.write(lZigZag, 12);
+      }
+      else{
+	aOut.write(15, 4);
+	aOut.write(lZigZag, 64);
+      }
+
+      lPrevious = lValue;
+      lDelta = lNewDelta;
+    }
+  }
+
+  template <typename T>
+  void decodeDelta(BitReader &aIn, T *aValues, const int aCount) {
+    uint64_t lPrevious = 0;
+    uint64_t lDelta = 0;
+    for(int i = 0; i < aCount; i++){
+      uint64_t lZigZag = 0;
+      if(aIn.readBit()){
+	if(!aIn.readBit())
+	  lZigZag = aIn.read(7);
+	else if(!aIn.readBit())
+	  lZigZag = aIn.read(9);
+	else if(!aIn.readBit())
+	  lZigZag = aIn.read(12);
+	else
+	  lZigZag = aIn.read(64);
+      }
+      const uint64_t lDod = (lZigZag >> 1) ^ ((uint64_t) 0 - (lZigZag & 1));
+
+      lDelta += lDod;
+      lPrevious += lDelta;
+      aValues[i] = (T) (int64_t) lPrevious;
+    }
+  }
+
+  // XOR: the first value is stored as is, then each one as its XOR
+  // with the value before.
+  //   0  - same value as before
+  //   10 - the changed bits fit where the last ones were
+  //   11 - 6 bits of leading zeros, 6 bits of length - 1, then the
+  //        changed bits
+  // A float's bits are the low 32 of the 64, so always have at least
+  // 32 leading zeros.
+  template <typename T>
+  void encodeXor(const T *aValues, const int aCount, BitWriter &aOut) {
+    uint64_t lPrevious = toBits(aValues[0]);
+    int lLeading = -1;
+    int lTrailing = 0;
+
+    aOut.write(lPrevious, 64);
+    for(int i = 1; i < aCount; i++){
+      const uint64_t lValue = toBits(aValues[i]);
+      const uint64_t lXor = lValue ^ lPrevious;
+      lPrevious = lValue;
+
+      if(lXor == 0){
+	aOut.write(0, 1);
+	continue;
+      }
+
+      const int lNewLeading = leadingZeros(lXor);
+      const int lNewTrailing = trailingZeros(lXor);
+      if(lLeading >= 0 && lNewLeading >= lLeading &&
+	 lNewTrailing >= lTrailing){
+	aOut.write(2, 2);
+	aOut.write(lXor >> lTrailing, 64 - lLeading - lTrailing);
+      }
+      else{
+	lLeading = lNewLeading;
+	lTrailing = lNewTrailing;
+	const int lLength = 64 - lLeading - lTrailing;
+	aOut.write(3, 2);
+	aOut.write(lLeading, 6);
+	aOut.write(lLength - 1, 6);
+	aOut.write(lXor >> lTrailing, lLength);
+      }
+    }
+  }
+
+  template <typename T>
+  void decodeXor(BitReader &aIn, T *aValues, const int aCount) {
+    uint64_t lPrevious = aIn.read(64);
+    int lLeading = 0;
+    int lTrailing = 0;
+
+    fromBits(lPrevious, aValues[0]);
+    for(int i = 1; i < aCount; i++){
+      if(aIn.readBit()){
+	if(aIn.readBit()){
+	  lLeading = (int) aIn.read(6);
+	  lTrailing = 64 - lLeading - ((int) aIn.read(6) + 1);
+	  if(lTrailing < 0)
+	    lTrailing = 0;
+	}
+	lPrevious ^= aIn.read(64 - lLeading - lTrailing) << lTrailing;
+      }
+      fromBits(lPrevious, aValues[i]);
+    }
+  }
+}
+
+void
+SeriesCodec::encode(const double *aValues, const int aCount,
+		    std::vector<char> &aOut)
+{
+  if(aCount <= 0)
+    return;
+
+  BitWriter lOut(aOut);
+  if(allWhole(aValues, aCount)){
+    aOut.push_back(kCODEC_DELTA);
+    encodeDelta(aValues, aCount, lOut);
+  }
+  else{
+    aOut.push_back(kCODEC_XOR);
+    encodeXor(aValues, aCount, lOut);
+  }
+  lOut.flush();
+}
+
+void
+SeriesCodec::encode(const float *aValues, const int aCount,
+		    std::vector<char> &aOut)
+{
+  if(aCount <= 0)
+    return;
+
+  BitWriter lOut(aOut);
+  aOut.push_back(kCODEC_XOR_FLOAT);
+  encodeXor(aValues, aCount, lOut);
+  lOut.flush();
+}
+
+void
+SeriesCodec::encode(const int64_t *aValues, const int aCount,
+		    std::vector<char> &aOut)
+{
+  if(aCount <= 0)
+    return;
+
+  BitWriter lOut(aOut);
+  aOut.push_back(kCODEC_DELTA);
+  encodeDelta(aValues, aCount, lOut);
+  lOut.flush();
+}
+
+bool
+SeriesCodec::decode(const char *aData, const size_t aBytes,
+		    double *aValues, const int aCount)
+{
+  if(aCount <= 0)
+    return true;
+  if(aBytes < 1)
+    return false;
+
+  BitReader lIn(aData + 1, aBytes - 1);
+  switch(aData[0]){
+  case kCODEC_DELTA:
+    decodeDelta(lIn, aValues, aCount);
+    break;
+  case kCODEC_XOR:
+    decodeXor(lIn, aValues, aCount);
+    break;
+  default:
+    return false;
+  }
+
+  return !lIn.failed();
+}
+
+bool
+SeriesCodec::decode(const char *aData, const size_t aBytes,
+		    float *aValues, const int aCount)
+{
+  if(aCount <= 0)
+    return true;
+  if(aBytes < 1 || aData[0] != kCODEC_XOR_FLOAT)
+    return false;
+
+  BitReader lIn(aData + 1, aBytes - 1);
+  decodeXor(lIn, aValues, aCount);
+  return !lIn.failed();
+}
+
+bool
+SeriesCodec::decode(const char *aData, const size_t aBytes,
+		    int64_t *aValues, const int aCount)
+{
+  if(aCount <= 0)
+    return true;
+  if(aBytes < 1 || aData[0] != kCODEC_DELTA)
+    return false;
+
+  BitReader lIn(aData + 1, aBytes - 1);
+  decodeDelta(lIn, aValues, aCount);
+  return !lIn.failed();
+}
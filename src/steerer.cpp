@@ -55,12 +55,14 @@
     @author Andrew Porter */
 
 #include <qapplication.h>
+#include <cstring>
 
 #include "buildconfig.h"
 #include "steerermainwindow.h"
 #include "exception.h"
 #include "types.h"
 #include "debug.h"
+#include "tracerecorder.h"
 
 #include "ReG_Steer_Steerside.h"
 
@@ -136,6 +138,7 @@ extern "C" void signalHandler(int aSignal)
 
   cout << "Steerer quitting..." << endl;
   delete gSteererMainWindowSelfPtr;
+  TraceRecorder::shutdown();
   if (Steerer_finalize() != REG_SUCCESS) {
     REG_DBGEXCP("Steerer_finalize failed");
   }
@@ -210,11 +213,20 @@ int main( int argc, char ** argv )
 #endif
     */
 
+    // Pick out our own options - anything else is taken to be an SGS
+    const char *lSGS = kNULL;
+    for (int i = 1; i < lApp.argc(); i++){
+      if (strcmp(lApp.argv()[i], "-trace") == 0 && i + 1 < lApp.argc())
+	TraceRecorder::enable(lApp.argv()[++i]);
+      else
+	lSGS = lApp.argv()[i];
+    }
+
     // MR Check to see if we were supplied with an SGS as a command line arg
     // if so - we've been started from the QT launcher, so go directly to the
     // main Steering window without using the Grid Attach dialog.
-    if (argc == 2)
-      lSteererMainWindow = new SteererMainWindow(true, argv[1]);
+    if (lSGS)
+      lSteererMainWindow = new SteererMainWindow(true, lSGS);
     else
       lSteererMainWindow = new SteererMainWindow();
     gSteererMainWindowSelfPtr = lSteererMainWindow;
@@ -226,6 +238,8 @@ int main( int argc, char ** argv )
     result = lApp.exec();
 
     delete lSteererMainWindow;
+    // the threads that record have gone with the main window
+    TraceRecorder::shutdown();
 
     REG_DBGLOG("Steerer quitting.");
 
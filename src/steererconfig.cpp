@@ -71,6 +71,13 @@ SteererConfig::SteererConfig(){
   mKeyPassphrase = "";
   mAutoPollingOn = true;
   mPollingIntervalSecs = float(kMIN_POLLING_INT) / 1000.f;
+  mLatencyTargetSecs = float(kLATENCY_TARGET) / 1000.f;
+  mDrainMaxMessages = kDRAIN_MAX_MSGS;
+  mDrainMaxSecs = float(kDRAIN_MAX_TIME) / 1000.f;
+  mHistoryOnlyDepth = kHISTORY_ONLY_DEPTH;
+  mHistoryHotValues = kHISTORY_HOT_VALUES;
+  mHistoryCompress = true;
+  mHistoryRetainValues = 0;
   mShowMonParamTable = true;
   mShowSteerParamTable = true;
   mShowIOTypeTable = true;
@@ -146,6 +153,26 @@ void SteererConfig::readConfig(QString fileName){
     mPollingIntervalSecs = flag.toFloat();
     REG_DBGMSG1("Default fixed polling interval is ",
 		mPollingIntervalSecs);
+
+    flag = getElementAttrValue(nodeList.item(0).toElement(),
+			       "latencyTarget");
+    if(flag.toFloat() > 0.f)
+      mLatencyTargetSecs = flag.toFloat();
+    REG_DBGMSG1("Latency target for auto polling is ", mLatencyTargetSecs);
+
+    // Limits on how much to handle in one go when messages are
+    // queued up. Leave the defaults alone if not set.
+    flag = getElementAttrValue(nodeList.item(0).toElement(),
+			       "drainMaxMessages");
+    if(flag.toInt() > 0)
+      mDrainMaxMessages = flag.toInt();
+    REG_DBGMSG1("Max. messages per drain is ", mDrainMaxMessages);
+
+    flag = getElementAttrValue(nodeList.item(0).toElement(),
+			       "drainMaxTime");
+    if(flag.toFloat() > 0.f)
+      mDrainMaxSecs = flag.toFloat();
+    REG_DBGMSG1("Max. time per drain is ", mDrainMaxSecs);
   }
 
   // GUI display section
@@ -194,6 +221,47 @@ void SteererConfig::readConfig(QString fileName){
     } else {
       REG_DBGMSG("Display of ChkTypes table is OFF");
     }
+
+    // How far the display can fall behind. Leave the default alone
+    // if not set.
+    flag = getElementAttrValue(nodeList.item(0).toElement(),
+			       "historyOnlyDepth");
+    if(flag.toInt() > 0)
+      mHistoryOnlyDepth = flag.toInt();
+    REG_DBGMSG1("History-only depth is ", mHistoryOnlyDepth);
+  }
+
+  // History section - optional
+  nodeList = docElem.elementsByTagName("History");
+  if(nodeList.count() == 1){
+    mHistorySpoolDir = getElementAttrValue(nodeList.item(0).toElement(),
+					   "spoolDir");
+    flag = getElementAttrValue(nodeList.item(0).toElement(), "hotValues");
+    if(!flag.isEmpty() && flag.toInt() >= 0)
+      mHistoryHotValues = flag.toInt();
+    REG_DBGMSG1("History values kept in memory: ", mHistoryHotValues);
+    flag = getElementAttrValue(nodeList.item(0).toElement(), "compress");
+    if(!flag.isEmpty())
+      mHistoryCompress = (flag.contains("on") == 1);
+    REG_DBGMSG1("Compress older history values: ", mHistoryCompress);
+    flag = getElementAttrValue(nodeList.item(0).toElement(),
+			       "retainValues");
+    if(!flag.isEmpty() && flag.toInt() >= 0)
+      mHistoryRetainValues = flag.toInt();
+    REG_DBGMSG1("History values retained: ", mHistoryRetainValues);
+    mHistoryCacheDir = getElementAttrValue(nodeList.item(0).toElement(),
+					   "cacheDir");
+  }
+
+  // Statistics section - optional
+  nodeList = docElem.elementsByTagName("Statistics");
+  if(nodeList.count() == 1){
+    mStatsDumpFile = getElementAttrValue(nodeList.item(0).toElement(),
+					 "dumpFile");
+    REG_DBGMSG1("Statistics dump file is ", mStatsDumpFile.ascii());
+    mTraceFile = getElementAttrValue(nodeList.item(0).toElement(),
+				     "traceFile");
+    REG_DBGMSG1("Trace file is ", mTraceFile.ascii());
   }
 
   return;
@@ -73,27 +73,65 @@
 #include <qtooltip.h>
 #include <qwidget.h>
 #include <QStackedWidget>
+#include <QTimer>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
 //Added by qt3to4:
 #include <Q3HBoxLayout>
 #include <QEvent>
 #include <Q3Action>
 
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <vector>
+
 #include "buildconfig.h"
 #include "types.h"
 #include "debug.h"
 #include "exception.h"
 #include "steerermainwindow.h"
 #include "commsthread.h"
+#include "commswaiter.h"
 #include "application.h"
 #include "attachform.h"
 #include "attachsockets.h"
 #include "configform.h"
+#include "tracerecorder.h"
+
+#include <boost/bind.hpp>
 
 #include "ReG_Steer_Steerside.h"
 
 extern unsigned char reg_logo[];
 extern unsigned int  reg_logo_len;
 
+/// Sim_attach, noting the socket the library opens to talk to the
+/// application (if any). Run as a single task by the ReGExecutor so
+/// that no other library call can open or close sockets while the
+/// ones that are open before and after are compared.
+static int attachFindingSocket(char *aSimID, int *aSimHandle, int *aFd)
+{
+  std::set<int> lSocketsBefore = CommsWaiter::openSockets();
+
+  const int lStatus = Sim_attach(aSimID, aSimHandle);  //ReG library
+  if(lStatus != REG_SUCCESS)
+    return lStatus;
+
+  std::set<int> lSocketsAfter = CommsWaiter::openSockets();
+  std::vector<int> lNew;
+  std::set_difference(lSocketsAfter.begin(), lSocketsAfter.end(),
+		      lSocketsBefore.begin(), lSocketsBefore.end(),
+		      std::back_inserter(lNew));
+  // Only trust it if there is no ambiguity
+  if(lNew.size() == 1)
+    *aFd = lNew[0];
+
+  return lStatus;
+}
+
 SteererMainWindow::SteererMainWindow(bool autoConnect, const char *aSGS)
   : Q3MainWindow( 0, "steerermainwindow"), mCentralWgt(kNULL),
     mTopLayout(kNULL), mStack(kNULL), mAppTabs(kNULL),
@@ -226,6 +264,29 @@ SteererMainWindow::SteererMainWindow(bool autoConnect, const char *aSGS)
 	  SLOT(hideMonTableSlot()));
   mHideMonTableAction->addTo(lViewMenu);
 
+  mShowCallStatsAction = new Q3Action("Show steering library call timings",
+				      "Show library call &timings",
+				      Qt::CTRL+Qt::Key_T, this,
+				      "showcallstatsaction");
+  connect(mShowCallStatsAction, SIGNAL(activated()), this,
+	  SLOT(showCallStatsSlot()));
+  mShowCallStatsAction->addTo(lViewMenu);
+
+  mShowLatencyStatsAction = new Q3Action("Show message latencies",
+					 "Show message &latencies",
+					 Qt::CTRL+Qt::Key_L, this,
+					 "showlatencyaction");
+  connect(mShowLatencyStatsAction, SIGNAL(activated()), this,
+	  SLOT(showLatencyStatsSlot()));
+  mShowLatencyStatsAction->addTo(lViewMenu);
+
+  mSaveLatencyStatsAction = new Q3Action("Save message latencies to a file",
+					 "Save message latencies...",
+					 0, this, "savelatencyaction");
+  connect(mSaveLatencyStatsAction, SIGNAL(activated()), this,
+	  SLOT(saveLatencyStatsSlot()));
+  mSaveLatencyStatsAction->addTo(lViewMenu);
+
   // Catch tab changes so we can keep the status bar relevant
   connect(mAppTabs, SIGNAL(currentChanged(int)), this,
 	  SLOT(tabChangedSlot(int)));
@@ -235,10 +296,20 @@ SteererMainWindow::SteererMainWindow(bool autoConnect, const char *aSGS)
 
   statusBar()->message("www.realitygrid.org");
 
+  // How the current application is being polled
+  mPollStatsLabel = new QLabel(this);
+  statusBar()->addPermanentWidget(mPollStatsLabel);
+  mPollStatsTimer = new QTimer(this);
+  connect(mPollStatsTimer, SIGNAL(timeout()), this,
+	  SLOT(updatePollStatsSlot()));
+  mPollStatsTimer->start(1000);
+
   // Read configuration file (if any)
   mSteererConfig = new SteererConfig();
   mSteererConfig->readConfig(QString(getenv("HOME")) +
 			     "/.realitygrid/steerer.conf");
+  if(!mSteererConfig->mTraceFile.isEmpty() && !TraceRecorder::isEnabled())
+    TraceRecorder::enable(mSteererConfig->mTraceFile);
 
   mSteererConfig->mRegistrySecurity.use_ssl = 0;
   if(mSteererConfig->mTopLevelRegistry.startsWith("https://")){
@@ -249,7 +320,7 @@ SteererMainWindow::SteererMainWindow(bool autoConnect, const char *aSGS)
 
   // create commsthread so can set checkinterval
   // - thread is started on first attach
-  mCommsThread = new CommsThread(this, &mReGMutex,
+  mCommsThread = new CommsThread(this, &mExecutor,
 				 (int)(1000.0*mSteererConfig->mPollingIntervalSecs));
   if (mCommsThread != kNULL){
     mSetCheckIntervalAction->setEnabled(TRUE);
@@ -289,6 +360,11 @@ SteererMainWindow::cleanUp()
   delete mCommsThread;
   mCommsThread = kNULL;
 
+  // now that nothing else is going on, save the timings if asked to
+  if(mSteererConfig && !mSteererConfig->mStatsDumpFile.isEmpty())
+    dumpStats(mSteererConfig->mStatsDumpFile);
+  TraceRecorder::write();
+
   // ARP - List of applications uses autodelete so automatically
   // cleaned up when list object deleted
 
@@ -319,6 +395,11 @@ SteererMainWindow::customEvent(QEvent *aEvent)
   // this function will be executed when main GUI thread gets round to processing
   // the event posted by our CommsThread.
 
+  // don't detach from the applications from under a library call
+  // the GUI thread is waiting for
+  if (mExecutor.deferEvent(this, aEvent->type()))
+    return;
+
   // only expect events with type (User+kSIGNAL_EVENT)
   if (aEvent->type() == QEvent::User+kSIGNAL_EVENT)
   {
@@ -441,8 +522,14 @@ void SteererMainWindow::simAttachApp(const char* aSimID, bool aIsLocal)
   /* Attempt to attach to a simulation */
   int lReGStatus = REG_FAILURE;
   int lSimHandle = -1;
+  int lAppFd = -1;
+  QString lSteerDir;
+  // What the application's cached histories are kept by
+  QString lHistoryKey(aSimID);
   bool ok;
   struct reg_security_info sec;
+  // Times the attach and how long the application takes to get going
+  lunchbox::Clock lAttachClock;
   try
   {
     QString idStr(aSimID);
@@ -460,23 +547,43 @@ void SteererMainWindow::simAttachApp(const char* aSimID, bool aIsLocal)
 	      mSteererConfig->mRegistrySecurity.caCertsPath,
 	      REG_MAX_STRING_LENGTH);
       // WSRF support only for version >= 2.0
-      mReGMutex.lock();
-      lReGStatus = Sim_attach_secure(aSimID, &sec,
-				     &lSimHandle); // ReG library
-      mReGMutex.unlock();
+      lAttachClock.reset();
+      lReGStatus = mExecutor.callFromGui(REG_CALL_SITE("Sim_attach_secure"), // ReG library
+					 boost::bind(Sim_attach_secure, aSimID,
+						     &sec, &lSimHandle));
     }
     else{
-      mReGMutex.lock();
-      lReGStatus = Sim_attach((char*) aSimID, &lSimHandle);  //ReG library
-      mReGMutex.unlock();
+      // The Files transport uses REG_STEER_DIRECTORY if it is not
+      // given a directory
+      if(*mSteerType == "Files"){
+	lSteerDir = (aSimID && *aSimID) ? QString(aSimID) :
+	  QString(getenv("REG_STEER_DIRECTORY"));
+	// a directory can be named more than one way
+	lHistoryKey = QDir::cleanPath(QDir(lSteerDir).absolutePath());
+      }
+
+      // With Sockets, spot the socket the library opens to talk to
+      // this application
+      lAttachClock.reset();
+      if(*mSteerType == "Sockets")
+	lReGStatus = mExecutor.callFromGui(REG_CALL_SITE("Sim_attach"),
+					   boost::bind(attachFindingSocket,
+						       (char*) aSimID, &lSimHandle,
+						       &lAppFd));
+      else
+	lReGStatus = mExecutor.callFromGui(REG_CALL_SITE("Sim_attach"),  //ReG library
+					   boost::bind(Sim_attach, (char*) aSimID,
+						       &lSimHandle));
     }
 
     if (lReGStatus == REG_SUCCESS)
     {
       REG_DBGMSG1("Attached: mSimHandle = ",lSimHandle);
+      const float lAttachMs = lAttachClock.getTimef();
 
       mAppList.append(new Application(this, aSimID, lSimHandle, aIsLocal,
-				      &mReGMutex));
+				      &mExecutor, lHistoryKey));
+      mAppList.current()->startTiming(lAttachMs, lAttachClock.getTimef());
 
       // get supported command list from library and enable buttons
       // appropriately
@@ -498,7 +605,7 @@ void SteererMainWindow::simAttachApp(const char* aSimID, bool aIsLocal)
       if (!isThreadRunning())
       {
 	if (mCommsThread == kNULL)
-	  mCommsThread = new CommsThread(this, &mReGMutex);
+	  mCommsThread = new CommsThread(this, &mExecutor);
 
 	if (mCommsThread == kNULL)
 	  THROWEXCEPTION("Thread not instantiated");
@@ -511,6 +618,9 @@ void SteererMainWindow::simAttachApp(const char* aSimID, bool aIsLocal)
 	}
       }
 
+      mCommsThread->addApplication(lSimHandle, mAppList.current(), lAppFd,
+				   lSteerDir);
+
     }
     else
     {
@@ -557,6 +667,9 @@ SteererMainWindow::closeApplicationSlot(int aSimHandle)
     mCommsThread->stop();
   }
 
+  if(mCommsThread)
+    mCommsThread->removeApplication(aSimHandle);
+
   REG_DBGMSG("closeApplicationSlot: deleting Application...");
 
   for(i=0; i<mAppList.count(); i++){
@@ -639,14 +752,21 @@ void
 SteererMainWindow::configureSteererSlot()
 {
 
-  ConfigForm *lConfigForm = new ConfigForm(mCommsThread->getCheckInterval(),
-					   this);
+  // With auto polling on the interval is chosen for us so set the
+  // latency it aims for instead
+  const bool lAuto = mCommsThread->getUseAutoPollFlag();
+  ConfigForm *lConfigForm =
+    new ConfigForm(lAuto ? mCommsThread->getLatencyTarget() :
+		   mCommsThread->getCheckInterval(),
+		   lAuto ? "latency target" : "interval", this);
 
   if ( lConfigForm->exec() == QDialog::Accepted )
   {
-    REG_DBGMSG1("config applied, interval= ", lConfigForm->getIntervalValue());
-     mCommsThread->setCheckInterval(lConfigForm->getIntervalValue());
-
+    REG_DBGMSG1("config applied, value= ", lConfigForm->getIntervalValue());
+    if(lAuto)
+      mCommsThread->setLatencyTarget(lConfigForm->getIntervalValue());
+    else
+      mCommsThread->setCheckInterval(lConfigForm->getIntervalValue());
   }
   else {
     REG_DBGMSG("Config cancelled");
@@ -698,6 +818,7 @@ SteererMainWindow::tabChangedSlot(int index)
 
   // Update the status bar so it is relevant to this tab
   statusBar()->message( aApp->getCurrentStatus() );
+  updatePollStatsSlot();
 
   // Ensure the View menu reflects what is being displayed on this
   // tab
@@ -807,6 +928,75 @@ void SteererMainWindow::hideMonTableSlot()
   }
 }
 
+void SteererMainWindow::showCallStatsSlot()
+{
+  QMessageBox lBox(QMessageBox::Information, "Steering Library Calls",
+		   "Time spent in each steering library call",
+		   QMessageBox::Ok, this);
+  lBox.setDetailedText(mExecutor.getStatsReport());
+  lBox.exec();
+}
+
+void SteererMainWindow::updatePollStatsSlot()
+{
+  Application *lApp = (Application *)(mAppTabs->currentPage());
+  PollScheduler::AppStats lStats;
+
+  if(!lApp || !isThreadRunning() ||
+     !mCommsThread->getPollStats(lApp->getHandle(), lStats)){
+    mPollStatsLabel->clear();
+    return;
+  }
+
+  mPollStatsLabel->setText(QString("Poll: %1 ms, hits: %2%")
+			   .arg(lStats.mInterval)
+			   .arg((int)(100.0f * lStats.mHitRatio)));
+}
+
+void SteererMainWindow::showLatencyStatsSlot()
+{
+  QMessageBox lBox(QMessageBox::Information, "Message Latencies",
+		   "Time messages spend between the steering library "
+		   "and the tables",
+		   QMessageBox::Ok, this);
+  lBox.setDetailedText(mLatencyStats.getReport());
+  lBox.exec();
+}
+
+bool SteererMainWindow::dumpStats(const QString &aFileName)
+{
+  QFile lFile(aFileName);
+
+  if(!lFile.open(QIODevice::WriteOnly | QIODevice::Text)){
+    cerr << "Failed to write statistics to " << aFileName.ascii() << endl;
+    return false;
+  }
+
+  QTextStream lStream(&lFile);
+  lStream << "# Steerer statistics, "
+	  << QDateTime::currentDateTime().toString(Qt::ISODate) << "\n\n"
+	  << "# Steering library calls\n" << mExecutor.getStatsReport()
+	  << "\n# Message latencies\n" << mLatencyStats.getReport();
+
+  return true;
+}
+
+void SteererMainWindow::saveLatencyStatsSlot()
+{
+  QString lFileName = Q3FileDialog::getSaveFileName(QString::null,
+						    "Text files (*.txt)",
+						    this, "savelatency",
+						    "Save message latencies");
+  if(lFileName.isEmpty())
+    return;
+
+  if(!mLatencyStats.dump(lFileName))
+    QMessageBox::warning(this, "Steerer Error",
+			 "Failed to write " + lFileName,
+			 QMessageBox::Ok, QMessageBox::NoButton,
+			 QMessageBox::NoButton);
+}
+
 bool SteererMainWindow::autoPollingOn()
 {
   return mSteererConfig->mAutoPollingOn;
@@ -821,3 +1011,28 @@ SteererConfig *SteererMainWindow::getConfig()
 {
   return mSteererConfig;
 }
+
+void SteererMainWindow::wakeCommsThread()
+{
+  if(mCommsThread)
+    mCommsThread->wakeup();
+}
+
+ReGExecutor *SteererMainWindow::getExecutor()
+{
+  return &mExecutor;
+}
+
+LatencyStats *SteererMainWindow::getLatencyStats()
+{
+  return &mLatencyStats;
+}
+
+bool SteererMainWindow::takeStatusUpdate(int aSimHandle,
+					 StatusUpdate &aUpdate)
+{
+  if(!mCommsThread)
+    return false;
+
+  return mCommsThread->takeStatusUpdate(aSimHandle, aUpdate);
+}
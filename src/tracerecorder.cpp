@@ -0,0 +1,298 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file tracerecorder.cpp
+    @brief Implementation of the TraceRecorder class
+    @author Robert Haines */
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QFile>
+#include <QMutex>
+#include <QTextStream>
+#include <QThreadStorage>
+
+#include <vector>
+#include <lunchbox/clock.h>
+
+#include "buildconfig.h"
+#include "types.h"
+#include "tracerecorder.h"
+#include "debug.h"
+
+// Events are stored in fixed-size chunks so that a buffer never
+// moves once written to, which lets write() read it while its thread
+// is still adding to it
+static const int kCHUNK_SIZE = 4096;
+
+namespace {
+
+struct TraceEvent {
+  const char *mCategory;
+  const char *mName;
+  int         mSimHandle;
+  int64_t     mStart;
+  int64_t     mDuration;
+};
+
+struct TraceChunk {
+  TraceChunk() : mUsed(0), mNext(0) {}
+  TraceEvent              mEvents[kCHUNK_SIZE];
+  /// How many of mEvents are complete - only the owning thread
+  /// increases it
+  QAtomicInt              mUsed;
+  QAtomicPointer<TraceChunk> mNext;
+};
+
+/// The events recorded by one thread. Only that thread adds to it;
+/// it is not freed until shutdown() so write() can always read it.
+struct ThreadBuffer {
+  ThreadBuffer(const int aId)
+    : mId(aId), mName(0), mHead(0), mTail(0), mNumEvents(0),
+      mDropped(0) {}
+  int          mId;
+  const char  *mName;
+  TraceChunk  *mHead;
+  TraceChunk  *mTail;
+  int          mNumEvents;
+  QAtomicInt   mDropped;
+};
+
+/// What QThreadStorage holds for each thread. It deletes this when
+/// the thread finishes, but not the buffer it points to.
+struct BufferRef {
+  BufferRef(ThreadBuffer *aBuffer, const int aGeneration)
+    : mBuffer(aBuffer), mGeneration(aGeneration) {}
+  ThreadBuffer *mBuffer;
+  /// The buffer has been freed if shutdown() has been called since
+  int           mGeneration;
+};
+
+// Guards sBuffers, sFileName and the buffers' names
+QMutex                       sMutex;
+std::vector<ThreadBuffer *>  sBuffers;
+QString                      sFileName;
+QThreadStorage<BufferRef *>  sThreadBuffer;
+// How many times shutdown() has been called
+QAtomicInt                   sGeneration;
+lunchbox::Clock              sClock;
+
+ThreadBuffer *
+threadBuffer()
+{
+  if(!sThreadBuffer.hasLocalData() ||
+     sThreadBuffer.localData()->mGeneration != (int) sGeneration){
+    QMutexLocker lLock(&sMutex);
+    ThreadBuffer *lBuffer = new ThreadBuffer(sBuffers.size() + 1);
+    sBuffers.push_back(lBuffer);
+    sThreadBuffer.setLocalData(new BufferRef(lBuffer, sGeneration));
+  }
+  return sThreadBuffer.localData()->mBuffer;
+}
+
+/// Quote a string for JSON
+QString
+quote(const QString &aString)
+{
+  QString lQuoted("\"");
+  for(int i = 0; i < (int) aString.length(); i++){
+    const QChar lChar = aString[i];
+    if(lChar == '"' || lChar == '\\')
+      lQuoted += QChar('\\');
+    if(lChar.unicode() < 0x20)
+      lQuoted += QString().sprintf("\\u%04x", lChar.unicode());
+    else
+      lQuoted += lChar;
+  }
+  return lQuoted + "\"";
+}
+
+} // namespace
+
+volatile bool TraceRecorder::sEnabled = false;
+
+void
+TraceRecorder::enable(const QString &aFileName)
+{
+  {
+    QMutexLocker lLock(&sMutex);
+    sFileName = aFileName;
+  }
+  // whoever turns it on is the GUI thread
+  setThreadName("GUI");
+  sEnabled = true;
+  REG_DBGMSG1("Recording trace to ", aFileName.ascii());
+}
+
+void
+TraceRecorder::setThreadName(const char *aName)
+{
+  ThreadBuffer *lBuffer = threadBuffer();
+  QMutexLocker lLock(&sMutex);
+  lBuffer->mName = aName;
+}
+
+int64_t
+TraceRecorder::now()
+{
+  return (int64_t)(sClock.getTimed() * 1000.0);
+}
+
+void
+TraceRecorder::record(const char *aCategory, const char *aName,
+		      const int aSimHandle, const int64_t aStart,
+		      const int64_t aEnd)
+{
+  if(!sEnabled)
+    return;
+
+  ThreadBuffer *lBuffer = threadBuffer();
+  if(lBuffer->mNumEvents >= kTRACE_MAX_EVENTS){
+    lBuffer->mDropped.ref();
+    return;
+  }
+
+  TraceChunk *lChunk = lBuffer->mTail;
+  if(!lChunk || (int) lChunk->mUsed == kCHUNK_SIZE){
+    TraceChunk *lNew = new TraceChunk();
+    if(lChunk)
+      lChunk->mNext.fetchAndStoreRelease(lNew);
+    else{
+      // write() only looks at mHead under the mutex
+      QMutexLocker lLock(&sMutex);
+      lBuffer->mHead = lNew;
+    }
+    lBuffer->mTail = lChunk = lNew;
+  }
+
+  const int lUsed = lChunk->mUsed;
+  TraceEvent &lEvent = lChunk->mEvents[lUsed];
+  lEvent.mCategory = aCategory;
+  lEvent.mName = aName;
+  lEvent.mSimHandle = aSimHandle;
+  lEvent.mStart = aStart;
+  lEvent.mDuration = aEnd - aStart;
+  // publish the event to write()
+  lChunk->mUsed.fetchAndStoreRelease(lUsed + 1);
+  lBuffer->mNumEvents++;
+}
+
+bool
+TraceRecorder::write()
+{
+  if(!sEnabled)
+    return false;
+
+  QMutexLocker lLock(&sMutex);
+  QFile lFile(sFileName);
+  if(!lFile.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+    REG_DBGMSG1("Couldn't write trace to ", sFileName.ascii());
+    return false;
+  }
+
+  QTextStream lStream(&lFile);
+  bool lFirst = true;
+  int lDropped = 0;
+
+  lStream << "{\"traceEvents\":[";
+  for(unsigned int i = 0; i < sBuffers.size(); i++){
+    const ThreadBuffer *lBuffer = sBuffers[i];
+    const QString lThread = QString(",\"pid\":1,\"tid\":%1")
+      .arg(lBuffer->mId);
+
+    lStream << (lFirst ? "\n" : ",\n")
+	    << "{\"name\":\"thread_name\",\"ph\":\"M\"" << lThread
+	    << ",\"args\":{\"name\":"
+	    << quote(lBuffer->mName ? QString(lBuffer->mName) :
+		     QString("Thread %1").arg(lBuffer->mId))
+	    << "}}";
+    lFirst = false;
+
+    for(TraceChunk *lChunk = lBuffer->mHead; lChunk;
+	lChunk = lChunk->mNext.fetchAndAddAcquire(0)){
+      const int lUsed = lChunk->mUsed.fetchAndAddAcquire(0);
+      for(int j = 0; j < lUsed; j++){
+	const TraceEvent &lEvent = lChunk->mEvents[j];
+	lStream << ",\n{\"name\":" << quote(lEvent.mName)
+		<< ",\"cat\":" << quote(lEvent.mCategory)
+		<< ",\"ph\":\"X\",\"ts\":" << (qlonglong) lEvent.mStart
+		<< ",\"dur\":" << (qlonglong) lEvent.mDuration << lThread;
+	if(lEvent.mSimHandle >= 0)
+	  lStream << ",\"args\":{\"sim\":" << lEvent.mSimHandle << "}";
+	lStream << "}";
+      }
+    }
+    lDropped += lBuffer->mDropped;
+  }
+  lStream << "\n],\"displayTimeUnit\":\"ms\","
+	  << "\"otherData\":{\"dropped\":" << lDropped << "}}\n";
+
+  REG_DBGMSG1("Wrote trace to ", sFileName.ascii());
+  return lFile.error() == QFile::NoError;
+}
+
+void
+TraceRecorder::shutdown()
+{
+  sEnabled = false;
+
+  QMutexLocker lLock(&sMutex);
+  for(unsigned int i = 0; i < sBuffers.size(); i++){
+    TraceChunk *lChunk = sBuffers[i]->mHead;
+    while(lChunk){
+      TraceChunk *lNext = lChunk->mNext;
+      delete lChunk;
+      lChunk = lNext;
+    }
+    delete sBuffers[i];
+  }
+  sBuffers.clear();
+
+  // a thread that records again gets a new buffer
+  sGeneration.ref();
+}
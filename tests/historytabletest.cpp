@@ -0,0 +1,204 @@
+/*
+  The RealityGrid Steerer
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+
+  Author: Robert Haines
+ */
+
+/** @file historytabletest.cpp
+    @brief Tests of splicing the logs of a HistoryTable
+    @author Robert Haines */
+
+#include <stdio.h>
+#include <vector>
+
+#include "historytable.h"
+
+#include "ReG_Steer_Steerside.h"
+
+static int sFailures = 0;
+
+#define CHECK(aCond)							\
+  do{									\
+    if(!(aCond)){							\
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,	\
+	      #aCond);							\
+      sFailures++;							\
+    }									\
+  } while(0)
+
+static const int kSEQ_NUM = 0;
+static const int kPARAM = 1;
+static const int kOTHER = 2;
+
+// aCount values from aFirst going up by aStep
+static std::vector<double>
+makeLog(const double aFirst, const double aStep,
+	const int aCount)
+{
+  std::vector<double> lValues;
+  for(int i = 0; i < aCount; i++)
+    lValues.push_back(aFirst + i * aStep);
+  return lValues;
+}
+
+// A cached log followed by a shorter fetched one: each is lined up by
+// its own sequence numbers, and the fetched values win where they
+// overlap
+static void
+testCachedThenShorterFetched()
+{
+  HistoryTable lTable;
+  lTable.setSeqNumHandle(kSEQ_NUM);
+
+  // seq nums 1 to 10
+  std::vector<double> lCachedSeq = makeLog(1.0, 1.0, 10);
+  std::vector<double> lCachedParam = makeLog(10.0, 10.0, 10);
+  std::vector<double> lCachedOther = makeLog(-1.0, -1.0, 10);
+  lTable.setCachedLog(kSEQ_NUM, lCachedSeq);
+  lTable.setCachedLog(kPARAM, lCachedParam);
+  lTable.setCachedLog(kOTHER, lCachedOther);
+  CHECK(lTable.getNumLogRows() == 10);
+  CHECK(lTable.getLogValue(kPARAM, 9) == 100.0);
+
+  // an empty fetch doesn't lose the cached logs
+  lTable.setLog(kSEQ_NUM, NULL, 0);
+  lTable.setLog(kPARAM, NULL, 0);
+  CHECK(lTable.getNumLogRows() == 10);
+  CHECK(lTable.getLogValue(kPARAM, 0) == 10.0);
+
+  // seq nums 6 to 10, without kOTHER
+  const std::vector<double> lFetchedSeq = makeLog(6.0, 1.0, 5);
+  const std::vector<double> lFetchedParam = makeLog(61.0, 10.0, 5);
+  lTable.setLog(kPARAM, &lFetchedParam[0], lFetchedParam.size());
+  lTable.setLog(kSEQ_NUM, &lFetchedSeq[0], lFetchedSeq.size());
+
+  CHECK(lTable.getNumLogRows() == 10);
+  for(int i = 0; i < 10; i++){
+    CHECK(lTable.getLogValue(kSEQ_NUM, i) == i + 1.0);
+    CHECK(lTable.getLogValue(kPARAM, i) == (i < 5 ? 10.0 * (i + 1) :
+					    10.0 * (i + 1) + 1.0));
+    CHECK(lTable.getLogValue(kOTHER, i) == -(i + 1.0));
+  }
+  CHECK(lTable.getLogSummary(kPARAM).mMax == 101.0);
+  CHECK(lTable.getLogSummary(kPARAM).mCount == 10);
+
+  // only the log rows from before the first status are used
+  StatusRecord lRecord;
+  lRecord.mSeqNum = 8;
+  ParamValue lValue;
+  lValue.parse(REG_DBL, "7.5");
+  lRecord.mHandles.push_back(kPARAM);
+  lRecord.mValues.push_back(lValue);
+  lTable.append(lRecord);
+
+  CHECK(lTable.getNumLogRows() == 7);
+  std::vector<double> lTimeline;
+  lTable.getTimeline(kPARAM, lTimeline);
+  CHECK(lTimeline.size() == 8);
+  CHECK(lTimeline[4] == 50.0);
+  CHECK(lTimeline[6] == 71.0);
+  CHECK(lTimeline[7] == 7.5);
+}
+
+// A fetched log that starts before the cached one and has all of its
+// sequence numbers replaces it
+static void
+testFetchedReplacesCached()
+{
+  HistoryTable lTable;
+  lTable.setSeqNumHandle(kSEQ_NUM);
+
+  std::vector<double> lCachedSeq = makeLog(5.0, 1.0, 3);
+  std::vector<double> lCachedParam = makeLog(1.0, 0.0, 3);
+  lTable.setCachedLog(kSEQ_NUM, lCachedSeq);
+  lTable.setCachedLog(kPARAM, lCachedParam);
+
+  const std::vector<double> lFetchedSeq = makeLog(1.0, 1.0, 10);
+  const std::vector<double> lFetchedParam = makeLog(2.0, 0.0, 10);
+  lTable.setLog(kSEQ_NUM, &lFetchedSeq[0], lFetchedSeq.size());
+  lTable.setLog(kPARAM, &lFetchedParam[0], lFetchedParam.size());
+
+  CHECK(lTable.getNumLogRows() == 10);
+  CHECK(lTable.getLogSummary(kPARAM).mMin == 2.0);
+  CHECK(lTable.getLogSummary(kPARAM).mMax == 2.0);
+}
+
+// Without SEQUENCE_NUM the logs can't be lined up, so the fetched ones
+// are used on their own once there are any
+static void
+testWithoutSeqNums()
+{
+  HistoryTable lTable;
+
+  std::vector<double> lCachedParam = makeLog(1.0, 1.0, 4);
+  std::vector<double> lCachedOther = makeLog(1.0, 1.0, 4);
+  lTable.setCachedLog(kPARAM, lCachedParam);
+  lTable.setCachedLog(kOTHER, lCachedOther);
+  CHECK(lTable.getNumLogRows() == 4);
+
+  lTable.setLog(kPARAM, NULL, 0);
+  CHECK(lTable.getNumLogRows() == 4);
+
+  const std::vector<double> lFetchedParam = makeLog(5.0, 1.0, 2);
+  lTable.setLog(kPARAM, &lFetchedParam[0], lFetchedParam.size());
+  CHECK(lTable.getNumLogRows() == 2);
+  CHECK(lTable.getLogValue(kPARAM, 1) == 6.0);
+  CHECK(lTable.getLogValue(kOTHER, 1) != lTable.getLogValue(kOTHER, 1));
+}
+
+int
+main()
+{
+  testCachedThenShorterFetched();
+  testFetchedReplacesCached();
+  testWithoutSeqNums();
+
+  if(sFailures > 0){
+    fprintf(stderr, "%d checks failed\n", sFailures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}